@@ -5,6 +5,8 @@ dst
 dst-native
 dst-js
 dst-wasm
+dst-wasm-simd
+dst-wasm-threads
 test/bin
 `.trim().split(/\n|\r\n?/).map(line => line.trim());
 
@@ -1,11 +1,29 @@
 #!/usr/bin/env node
-import { mkdir, readdir, readFile, writeFile } from "fs/promises";
+import { mkdir, readdir, readFile, rm, writeFile } from "fs/promises";
 import { spawnCommand } from "./spawnCommand.mjs";
 
 const emcc = process.platform.startsWith("win") ? "emcc.bat" : "emcc";
 
 const binDir = `test/bin/`;
 const test_o = binDir + "test.o";
+const test_all_o = binDir + "test-all.o";
+const reference_dft = binDir + "reference_dft";
+
+// Transforms with their own APIs (not prepare_fft/run_fft/delete_fft).
+// These are not versions in the sense of `ts/info.ts`.
+const extras = ["fixed47", "outOfCore", "slidingDFT", "dct", "ntt", "chirpz"];
+
+// Native programs using some extras.  Like the test program they are linked
+// with each version (or only with the given `versions`).
+const drivers = [
+  {name: "bench_fixed", source: "bench-fixed", extras: ["fixed47"]},
+  {name: "fft_file", source: "fft-file", extras: ["outOfCore"]},
+  {name: "bench_sliding", source: "bench-sliding", extras: ["slidingDFT"]},
+  {name: "bench_dct", source: "bench-dct", extras: ["dct"]},
+  {name: "bench_ntt", source: "bench-ntt", extras: ["ntt"]},
+  {name: "bench_chirpz", source: "bench-chirpz", extras: ["chirpz"]},
+  {name: "test_pruned", source: "test-pruned", extras: [], versions: ["fft47pruned"]},
+];
 
 async function compileNativeTest() {
   await mkdir(binDir, {recursive: true});
@@ -15,6 +33,37 @@ async function compileNativeTest() {
     "-I", "src",
     "test/native/test.c++",
   ]);
+  await spawnCommand("g++", [
+    "-c", "-O4",
+    "-o", test_all_o,
+    "-I", "src",
+    "test/native/test-all.c++",
+  ]);
+  await spawnCommand("g++", [
+    "-O4",
+    "-o", reference_dft,
+    "test/native/reference-dft.c++",
+  ]);
+  for (const {source} of drivers) {
+    await spawnCommand("g++", [
+      "-c", "-O4",
+      "-o", `${binDir}${source}.o`,
+      "-I", "src",
+      `test/native/${source}.c++`,
+    ]);
+  }
+}
+
+async function compileNativeExtras({outDir}) {
+  for (const extra of extras) {
+    console.log(`==== NATIVE ${extra} ====`);
+    await spawnCommand("g++", [
+      "-c",
+      "-O4",
+      "-o", `${outDir}/${extra}.o`,
+      `src/${extra}.c++`,
+    ]);
+  }
 }
 
 async function compileNative({version, outDir}) {
@@ -34,9 +83,73 @@ async function compileNative({version, outDir}) {
     test_o,
     fft_code_o,
   ]);
+
+  for (const {name, source, extras, versions} of drivers) {
+    if (versions && !versions.includes(version)) {
+      continue;
+    }
+    await spawnCommand("g++", [
+      "-O4",
+      "-o", `${binDir}${name}_${version}`,
+      `${binDir}${source}.o`,
+      ...extras.map(extra => `${outDir}/${extra}.o`),
+      fft_code_o,
+    ]);
+  }
 }
 
-async function compileWASMClang({version, outDir}) {
+// All versions in one library (see `src/engines.h++`), available as a
+// static and a shared library, and the test and benchmark programs using it.
+// The library always contains all versions, independently of VERSIONS.
+async function compileNativeLibrary({outDir}) {
+  const libDir = `${outDir}/lib`;
+  await mkdir(libDir, {recursive: true});
+  const objects = [];
+  for (const version of allVersions) {
+    console.log(`==== NATIVE library ${version} ====`);
+    const object = `${libDir}/${version}.o`;
+    await spawnCommand("g++", [
+      "-c",
+      "-O4",
+      "-fPIC",
+      `-DFFT_ENGINE=${version}`,
+      `-DFFT_ENGINE_SOURCE="${version}.c++"`,
+      "-o", object,
+      "src/engine.c++",
+    ]);
+    objects.push(object);
+  }
+  const registry = `${libDir}/engines.o`;
+  await spawnCommand("g++", [
+    "-c",
+    "-O4",
+    "-fPIC",
+    `-DFFT_ENGINES(X)=${allVersions.map(version => `X(${version})`).join(" ")}`,
+    "-o", registry,
+    "src/engines.c++",
+  ]);
+  objects.push(registry);
+
+  await rm(`${outDir}/libfft.a`, {force: true});
+  await spawnCommand("ar", ["rcs", `${outDir}/libfft.a`, ...objects]);
+  await spawnCommand("g++", ["-shared", "-o", `${outDir}/libfft.so`, ...objects]);
+
+  await spawnCommand("g++", [
+    "-O4",
+    "-o", binDir + "test_all",
+    test_all_o,
+    `${outDir}/libfft.a`,
+  ]);
+  await spawnCommand("g++", [
+    "-O4",
+    "-o", binDir + "bench_permute",
+    "-I", "src",
+    "test/native/bench-permute.c++",
+    `${outDir}/libfft.a`,
+  ]);
+}
+
+async function compileWASMClang({version, outDir, flags}) {
   const outFileBase = `${outDir}/${version}`;
   await spawnCommand(process.env.EMSDK + "/upstream/bin/clang", `
     --sysroot=${process.env.EMSDK}/upstream/emscripten/cache/sysroot
@@ -45,10 +158,20 @@ async function compileWASMClang({version, outDir}) {
     -O3
     -flto
     -nostdlib
+    -mbulk-memory
     -Wl,--no-entry
     -Wl,--export=prepare_fft
     -Wl,--export=run_fft
     -Wl,--export=delete_fft
+    -Wl,--export-if-defined=prepare_fft_pruned
+    -Wl,--export-if-defined=set_fft_output
+    -Wl,--export-if-defined=fft_input_buffer
+    -Wl,--export-if-defined=fft_output_buffer
+    -Wl,--export-if-defined=fft_set_inputs
+    -Wl,--export-if-defined=fft_get_outputs
+    -Wl,--export-if-defined=malloc
+    -Wl,--export-if-defined=free
+    -Wl,--export-if-defined=heap_reset
     -Wl,--unresolved-symbols=ignore-all
     -Wl,--import-undefined
     -Wl,--import-memory
@@ -64,14 +187,18 @@ async function compileWASMClang({version, outDir}) {
   // OTOH we cannot add this option unconditionally because
   // that would crash the linking of fftKiss2.
   // TODO Understand this better
-  .concat(/^fft0[12]$/.test(version) ? ["-Wl,-shared"] : [])
+  // Such modules have no `__heap_base` for the allocator in src/lib.c and
+  // therefore use the heap implementation in ts/makeHeap.ts.
+  .concat(/^fft0[12]$/.test(version) ? ["-Wl,-shared", "-DEXTERNAL_HEAP"] : [])
+  .concat(flags)
   .concat(process.env.CLANG_V ? ["-v"] : []),
   );
 }
 
-async function compileWASMEmscripten({version, outDir}) {
+async function compileWASMEmscripten({version, outDir, flags}) {
   const outFileBase = `${outDir}/${version}`;
   await spawnCommand(emcc, [
+    ...flags,
     ...process.env.EMCC_V ? ["-v"] : [],
     ...process.env.EMCC_G ? ["-g"] : [],
     "-o", `${outFileBase}.wasm`,
@@ -90,10 +217,28 @@ async function compileWASMEmscripten({version, outDir}) {
   ]);
 }
 
+// For the threaded flavor used by `ts/wasm-thread-pool.ts`:
+// All threads instantiate the module on the same shared memory.
+// The workers set their own `__stack_pointer`.
+// (Only the main thread uses the allocator in `src/lib.c`.)
+const threadFlags = [
+  "-matomics",
+  "-Wl,--shared-memory",
+  // Must match the maximum in `ts/api-wasm.ts`.
+  `-Wl,--max-memory=${1 << 30}`,
+  "-Wl,--export=__stack_pointer",
+  "-Wl,--export-if-defined=fft_parallel_steps",
+  "-Wl,--export-if-defined=run_fft_parallel",
+];
+
+// fft01 and fft02 need an imported stack pointer (see compileWASMClang)
+// and fftKiss2 is built with Emscripten.
+const isThreadable = version => !/^fft0[12]$|^fftKiss2$/.test(version);
+
 const compilerName = (process.env.COMPILER ?? "").charAt(0).toLowerCase();
 console.log(compilerName)
 
-async function compileWASM({version, outDir}) {
+async function compileWASM({version, outDir, flags = []}) {
   const compileWASMFunc =
     compilerName === "c" ? compileWASMClang :
     compilerName === "e" ? compileWASMEmscripten :
@@ -103,7 +248,7 @@ async function compileWASM({version, outDir}) {
     version === "fftKiss2" ? compileWASMEmscripten :
     compileWASMClang;
 
-  await compileWASMFunc({version, outDir});
+  await compileWASMFunc({version, outDir, flags});
 
   const outFileBase = `${outDir}/${version}`;
 
@@ -167,37 +312,53 @@ async function compileTechForVersion({tech, version, outDir}) {
     case "NATIVE": await compileNative({version, outDir}); break;
     case "JS"    : await compileJS    ({version, outDir}); break;
     case "WASM"  : await compileWASM  ({version, outDir}); break;
+    // SIMD128 is used by the hand-written code in `src/simd128.h++`
+    // and by the auto-vectorizer.
+    case "WASM_SIMD": await compileWASM({version, outDir, flags: ["-msimd128"]}); break;
+    case "WASM_THREADS":
+      if (isThreadable(version)) {
+        await compileWASM({version, outDir, flags: threadFlags});
+      } else {
+        console.log("(skipped)");
+      }
+      break;
     default:
       console.error(`
 Environment variable TECH has value "${process.env.TECH}".
 Comma-separated components of TECH should be:
-"NATIVE", "JS", "WASM"`);
+"NATIVE", "JS", "WASM", "WASM_SIMD", "WASM_THREADS"`);
       break;
   }
 }
 
 const { TECH, VERSIONS } = process.env
 
-const versions = VERSIONS ? VERSIONS.split(",") :
+const allVersions =
   (await readdir("src")).flatMap(name => {
     const match = name.match(/^(fft.+)\.c\+\+$/);
     return match ? [match[1]] : [];
   });
 
-const techs = (TECH ?? "NATIVE,JS,WASM").split(",").map(t => t.toUpperCase());
+const versions = VERSIONS ? VERSIONS.split(",") : allVersions;
+
+const techs = (TECH ?? "NATIVE,JS,WASM,WASM_SIMD,WASM_THREADS").split(",").map(t => t.toUpperCase());
 
 
 async function main() {
   try {
     for (const tech of techs) {
-      const outDir = "dst-" + tech.toLowerCase();
+      const outDir = "dst-" + tech.toLowerCase().replace("_", "-");
       await mkdir(outDir, {recursive: true});
       if (tech === "NATIVE") {
         await compileNativeTest();
+        await compileNativeExtras({outDir});
       }
       for (const version of versions) {
         await compileTechForVersion({tech, version, outDir});
       }
+      if (tech === "NATIVE") {
+        await compileNativeLibrary({outDir});
+      }
     }
   } catch (e) {
     console.error(e);
@@ -0,0 +1,124 @@
+#ifndef BUFFERS_HPP
+#define BUFFERS_HPP 1
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "complex.h++"
+
+// Input and output buffers owned by a plan.
+//
+// A host can fill the input buffer directly (e.g., through a Float64Array
+// view of the WebAssembly memory), run the plan from the input to the
+// output buffer, and read the output buffer directly, instead of
+// converting the values one at a time.  The buffers are allocated on first
+// use and freed with the plan.  They are aligned to a cache line.
+// They are allocated separately, so that an allocator rounding up block
+// sizes does not round up twice the size.
+
+const size_t bufferAlignment = 64;
+
+struct PlanBuffers {
+  // the allocated memory (or null pointers) and the aligned buffers in it
+  char* inputMemory;
+  char* outputMemory;
+  Complex* input;
+  Complex* output;
+
+  PlanBuffers() : inputMemory(0), outputMemory(0), input(0), output(0) {}
+  ~PlanBuffers() { release(); }
+  PlanBuffers(const PlanBuffers&) = delete;
+  PlanBuffers& operator=(const PlanBuffers&) = delete;
+
+  // Returns false if the buffers could not be allocated.
+  // (This uses malloc since `new` does not return a null pointer: it
+  // throws natively and traps in the `-nostdlib` WebAssembly builds.)
+  bool allocate(unsigned int n) {
+    if (input) {
+      return true;
+    }
+    const size_t size = n * sizeof(Complex) + bufferAlignment - 1;
+    inputMemory = (char*) malloc(size);
+    outputMemory = (char*) malloc(size);
+    if (!inputMemory || !outputMemory) {
+      release();
+      return false;
+    }
+    input = (Complex*) align(inputMemory);
+    output = (Complex*) align(outputMemory);
+    return true;
+  }
+
+  // input[i] = re[i] + i im[i] for i < n (with imaginary parts 0 if `im`
+  // is a null pointer).  Returns false if allocation failed.
+  bool setInputs(unsigned int n, const double* re, const double* im) {
+    if (!allocate(n)) {
+      return false;
+    }
+    for (unsigned int i = 0; i < n; i++) {
+      input[i] = Complex(re[i], im ? im[i] : 0);
+    }
+    return true;
+  }
+
+  // re[i] = Re(output[i]) and im[i] = Im(output[i]) for i < n
+  // (skipping `re` or `im` if it is a null pointer), or re[i] = the i-th
+  // double in the output buffer for the real-valued output modes.
+  // Returns false if allocation failed.
+  bool getOutputs(unsigned int n, bool realValued, double* re, double* im) {
+    if (!allocate(n)) {
+      return false;
+    }
+    if (realValued) {
+      const double* const values = (const double*) output;
+      for (unsigned int i = 0; re && i < n; i++) {
+        re[i] = values[i];
+      }
+      return true;
+    }
+    for (unsigned int i = 0; i < n; i++) {
+      const Complex z = output[i];
+      if (re) {
+        re[i] = z.real();
+      }
+      if (im) {
+        im[i] = z.imag();
+      }
+    }
+    return true;
+  }
+
+private:
+  static char* align(char* memory) {
+    const size_t mask = bufferAlignment - 1;
+    return (char*) (((size_t) memory + mask) & ~mask);
+  }
+
+  void release() {
+    free(inputMemory);
+    free(outputMemory);
+    inputMemory = outputMemory = 0;
+    input = output = 0;
+  }
+};
+
+class FFT;
+
+extern "C" {
+  // The plan-owned input and output buffers of n complex numbers each,
+  // or a null pointer if they could not be allocated.
+  // (Only provided by engines supporting it.)
+  Complex* fft_input_buffer(FFT* fft);
+  Complex* fft_output_buffer(FFT* fft);
+
+  // Copy separate arrays of real and imaginary parts (`im` may be a null
+  // pointer for real input) to the input buffer, or from the output buffer.
+  // For the real-valued output modes (see postprocess.h++) `fft_get_outputs`
+  // writes the n output values to `re`.
+  // Return 0 on success and -1 if the buffers could not be allocated.
+  // (Only provided by engines supporting it.)
+  int fft_set_inputs(FFT* fft, const double* re, const double* im);
+  int fft_get_outputs(FFT* fft, double* re, double* im);
+}
+
+#endif
@@ -1,6 +1,6 @@
 #include "c_bindings.h++"
 
-extern "C" {
+FFT_C_API_BEGIN
   FFT* prepare_fft(unsigned int n) {
     return new FFT(n);
   }
@@ -12,4 +12,4 @@ extern "C" {
   void delete_fft(FFT* fft) {
     delete fft;
   }
-}
+FFT_C_API_END
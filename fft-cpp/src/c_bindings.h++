@@ -11,4 +11,16 @@ extern "C" {
   void delete_fft(FFT* fft);
 }
 
+// Brackets for the C functions defined by a version.  In the engine library
+// (see engine.c++) every version is compiled within its own namespace and
+// these functions become C++ functions there, so that the versions do not
+// clash.
+#ifdef FFT_ENGINE
+#define FFT_C_API_BEGIN
+#define FFT_C_API_END
+#else
+#define FFT_C_API_BEGIN extern "C" {
+#define FFT_C_API_END }
+#endif
+
 #endif
@@ -0,0 +1,101 @@
+#include "chirpz.h++"
+#include "complex.h++"
+#include "c_bindings.h++"
+#include <math.h>
+
+// The engines are not tested with tiny sizes.
+static const unsigned int minSize = 16;
+
+// e^(-i TAU turns)
+static Complex turn(long double turns) {
+  const double TAU = 6.2831853071795864769;
+  return expi(-TAU * (double) (turns - floorl(turns)));
+}
+
+ChirpZ::ChirpZ(unsigned int n, unsigned int m, double start, double step) {
+  unsigned int size = minSize;
+  while (size < n + m - 1) {
+    size <<= 1;
+  }
+  const long double halfStep = 0.5L * step;
+
+  Complex* prechirp = new Complex[n];
+  for (unsigned int j = 0; j < n; j++) {
+    const long double jj = j;
+    prechirp[j] = turn(start * jj + halfStep * jj * jj);
+  }
+  Complex* postchirp = new Complex[m];
+  for (unsigned int k = 0; k < m; k++) {
+    const long double kk = k;
+    postchirp[k] = turn(halfStep * kk * kk) / (double) size;
+  }
+
+  // h[t] for -(n-1) <= t <= m-1 at t mod size, and 0 elsewhere
+  Complex* padded = new Complex[size];
+  for (unsigned int i = 0; i < size; i++) {
+    padded[i] = 0;
+  }
+  for (unsigned int t = 0; t < m; t++) {
+    const long double tt = t;
+    padded[t] = turn(-halfStep * tt * tt);
+  }
+  for (unsigned int t = 1; t < n; t++) {
+    const long double tt = t;
+    padded[size - t] = turn(-halfStep * tt * tt);
+  }
+  FFT* fft = prepare_fft(size);
+  Complex* kernel = new Complex[size];
+  run_fft(fft, padded, kernel, 1);
+  for (unsigned int i = 0; i < size; i++) {
+    padded[i] = 0;
+  }
+
+  this->n = n;
+  this->m = m;
+  this->size = size;
+  this->fft = fft;
+  this->prechirp = prechirp;
+  this->postchirp = postchirp;
+  this->kernel = kernel;
+  this->padded = padded;
+  this->spectrum = new Complex[size];
+  this->convolved = new Complex[size];
+}
+
+ChirpZ::~ChirpZ() {
+  delete_fft(fft);
+  delete[] prechirp;
+  delete[] postchirp;
+  delete[] kernel;
+  delete[] padded;
+  delete[] spectrum;
+  delete[] convolved;
+}
+
+void ChirpZ::run(const Complex* input, Complex* output) const {
+  for (unsigned int j = 0; j < n; j++) {
+    padded[j] = input[j] * prechirp[j];
+  }
+  run_fft(fft, padded, spectrum, 1);
+  for (unsigned int i = 0; i < size; i++) {
+    spectrum[i] = spectrum[i] * kernel[i];
+  }
+  run_fft(fft, spectrum, convolved, -1);
+  for (unsigned int k = 0; k < m; k++) {
+    output[k] = convolved[k] * postchirp[k];
+  }
+}
+
+extern "C" {
+  ChirpZ* prepare_chirpz(unsigned int n, unsigned int m, double start, double step) {
+    return new ChirpZ(n, m, start, step);
+  }
+
+  void run_chirpz(ChirpZ* cz, const Complex* input, Complex* output) {
+    cz->run(input, output);
+  }
+
+  void delete_chirpz(ChirpZ* cz) {
+    delete cz;
+  }
+}
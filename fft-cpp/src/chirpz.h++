@@ -0,0 +1,57 @@
+#ifndef CHIRPZ_HPP
+#define CHIRPZ_HPP 1
+
+#include "complex.h++"
+#include "c_bindings.h++"
+
+// The chirp-z transform ("zoom FFT"): m bins of the DTFT of n samples at
+// evenly spaced frequencies anywhere in the spectrum,
+//   X[k] = sum_{j<n} x[j] e^(-i TAU (start + k step) j)   for k < m,
+// with `start` and `step` in cycles per sample (i.e., divided by the
+// sample rate).  For step = 1/N this equals the bins of an N-point DFT of
+// the zero-padded input, but the cost depends on n + m rather than on N.
+//
+// Bluestein's algorithm: with jk = (j^2 + k^2 - (k-j)^2) / 2,
+//   X[k] = w[k] sum_j (x[j] e^(-i TAU start j) w[j]) h[k-j]
+// where w[j] = e^(-i PI step j^2) and h[t] = e^(i PI step t^2).
+// The sum is a convolution, computed as a cyclic convolution of
+// L >= n + m - 1 points (a power of 2) with two FFTs of the version this
+// code is linked with.  The chirps and the FFT of h are computed when the
+// plan is created.  The phases are reduced modulo a full turn in long
+// double, since j^2 step gets large.
+//
+// Input and output may be the same array (of max(n, m) entries).
+class ChirpZ {
+  unsigned int n;
+  unsigned int m;
+  unsigned int size;
+  FFT* fft;
+
+  // prechirp[j] = e^(-i TAU start j) w[j] for j < n
+  Complex* prechirp;
+  // postchirp[k] = w[k] / size for k < m (including the scaling of the
+  // unscaled inverse FFT)
+  Complex* postchirp;
+  // the FFT of h, arranged cyclically in `size` points
+  Complex* kernel;
+
+  // pre-allocated buffers of `size` complex numbers; the entries from n on
+  // in `padded` stay 0
+  Complex* padded;
+  Complex* spectrum;
+  Complex* convolved;
+
+public:
+  ChirpZ(unsigned int n, unsigned int m, double start, double step);
+  ~ChirpZ();
+
+  void run(const Complex* input, Complex* output) const;
+};
+
+extern "C" {
+  ChirpZ* prepare_chirpz(unsigned int n, unsigned int m, double start, double step);
+  void run_chirpz(ChirpZ* cz, const Complex* input, Complex* output);
+  void delete_chirpz(ChirpZ* cz);
+}
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef COBRA_HPP
+#define COBRA_HPP 1
+
+#include "complex.h++"
+#include "simd128.h++"
+
+#if defined(FFT_STREAM_STORES) && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Cache-blocked bit reversal for the first pass of large transforms
+// ("COBRA", see Carter and Gatlin, "Towards an optimal bit-reversal
+// permutation program", 1998).
+//
+// The first pass of the radix-2/4 engines reads its input in bit-reversed
+// order.  For large n this is a gather across the whole input, where almost
+// every access misses the cache (and the TLB).
+//
+// Split an index of lg(n) bits into the top `cobraBits` bits a, the bottom
+// `cobraBits` bits b, and the remaining middle bits c.  The bit reversal of
+// (a, c, b) is (rev(b), rev(c), rev(a)).  So for a fixed c, the inputs
+// (a, c, b) form a tile of rows of consecutive values, which are moved to
+// the rows (rev(b), rev(c), *) of consecutive outputs.  The tile is small
+// enough to stay in the L1 cache.
+//
+// Instead of writing the permuted values, `bitReversedGroups` passes them
+// to the first pass in groups of consecutive outputs, so the permutation
+// needs no extra pass over the data.
+
+const unsigned int cobraBits = 4;
+const unsigned int cobraSize = 1 << cobraBits;
+
+// The smallest n using the blocked permutation.  Below that, the input
+// mostly stays in the cache and the plain gather is faster
+// (see test/native/bench-permute.c++).
+const unsigned int cobraMinN = 1 << 18;
+
+// Calls group(i, x) for i = 0, groupSize, 2 * groupSize, ... < n, where
+// x[t] = f[bitReverse(i + t)] for t < groupSize.
+// n must be a power of 2 with n >= cobraSize^2, and groupSize must be a
+// power of 2 not larger than cobraSize.
+template <class Group>
+void bitReversedGroups(const Complex* f, unsigned int n, unsigned int groupSize, Group group) {
+  // bit reversal for indices of cobraBits bits
+  static const unsigned char reversed[cobraSize] = {
+    0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15,
+  };
+
+  unsigned int lgN = 0;
+  while ((1u << lgN) < n) {
+    lgN++;
+  }
+  const unsigned int middleBits = lgN - 2 * cobraBits;
+  const unsigned int topShift = lgN - cobraBits;
+  const unsigned int nMiddle = 1 << middleBits;
+
+  // tile[b * cobraSize + rev(a)] = f[(a, c, b)]
+  Complex tile[cobraSize * cobraSize];
+
+  unsigned int cReversed = 0;
+  for (unsigned int c = 0; c < nMiddle; c++) {
+    for (unsigned int a = 0; a < cobraSize; a++) {
+      const Complex* row = f + ((a << topShift) | (c << cobraBits));
+      if (c + 1 < nMiddle) {
+        // The row for the next c follows this one.  Having 16 rows in
+        // flight is more than the hardware prefetchers follow.
+        for (unsigned int b = 0; b < cobraSize; b += 4) {
+          __builtin_prefetch(row + cobraSize + b);
+        }
+      }
+      Complex* column = tile + reversed[a];
+      for (unsigned int b = 0; b < cobraSize; b++) {
+        column[b * cobraSize] = row[b];
+      }
+    }
+    for (unsigned int b = 0; b < cobraSize; b++) {
+      const unsigned int outRow = (reversed[b] << topShift) | (cReversed << cobraBits);
+      const Complex* tileRow = tile + b * cobraSize;
+      for (unsigned int a = 0; a < cobraSize; a += groupSize) {
+        group(outRow | a, tileRow + a);
+      }
+    }
+
+    // Increment cReversed as a bit-reversed counter of middleBits bits.
+    unsigned int bit = nMiddle >> 1;
+    while (cReversed & bit) {
+      cReversed ^= bit;
+      bit >>= 1;
+    }
+    cReversed |= bit;
+  }
+}
+
+// A store for the first pass of large transforms into `work`.
+// With FFT_STREAM_STORES (on x86) it uses non-temporal stores, which bypass
+// the cache.  That only pays off if `work` is much larger than the last
+// level cache, since the next stage reads it again.  Call `finish` after
+// the pass.
+struct CobraStore {
+  Complex* work;
+#if defined(FFT_STREAM_STORES) && defined(__SSE2__)
+  inline void operator()(unsigned int i, VComplex z) const {
+    _mm_stream_pd((double*) (work + i), _mm_set_pd(z.imag(), z.real()));
+  }
+  inline void finish() const {
+    _mm_sfence();
+  }
+#else
+  inline void operator()(unsigned int i, VComplex z) const {
+    vstore(work + i, z);
+  }
+  inline void finish() const {}
+#endif
+};
+
+#endif
@@ -0,0 +1,276 @@
+#include "dct.h++"
+#include "complex.h++"
+#include "c_bindings.h++"
+#include "tables.h++"
+#include <math.h>
+
+DCT::DCT(unsigned int n, int kind) {
+  const unsigned int halfN = n >> 1;
+
+  // All twiddle factors are powers of e^(i TAU / 8n).
+  const unsigned int m = 8 * n;
+  double* cosines = new double[2 * n + 1];
+  fillCosines(cosines, m, 2 * n + 1);
+  Complex* shifts = new Complex[halfN + 1];
+  Complex* twiddles = new Complex[halfN + 1];
+  const bool type4 = kind == DCT_IV || kind == DST_IV;
+  for (unsigned int k = 0; k <= halfN; k++) {
+    if (type4) {
+      shifts[k] = unitRoot(cosines, m, -(4 * k + 1));
+      twiddles[k] = unitRoot(cosines, m, -(4 * k));
+    } else {
+      shifts[k] = unitRoot(cosines, m, -(2 * k));
+      twiddles[k] = unitRoot(cosines, m, -(8 * k));
+    }
+  }
+  delete[] cosines;
+
+  this->n = n;
+  this->kind = kind;
+  this->fft = prepare_fft(halfN);
+  this->shifts = shifts;
+  this->twiddles = twiddles;
+  this->packed = new Complex[halfN];
+  this->spectrum = new Complex[halfN];
+}
+
+DCT::~DCT() {
+  delete_fft(fft);
+  delete[] shifts;
+  delete[] twiddles;
+  delete[] packed;
+  delete[] spectrum;
+}
+
+void DCT::run(const double* input, double* output) const {
+  switch (kind) {
+    case DCT_II:  runDCT2(input, output, false); break;
+    case DCT_III: runDCT3(input, output, false); break;
+    case DCT_IV:  runDCT4(input, output, false); break;
+    case DST_II:  runDCT2(input, output, true ); break;
+    case DST_III: runDCT3(input, output, true ); break;
+    case DST_IV:  runDCT4(input, output, true ); break;
+  }
+}
+
+// With v[j] = x[2j] and v[n-1-j] = x[2j+1] for j < n/2, the DCT-II is
+// X[k] = Re(e^(-i PI k / 2n) V[k]), where V is the DFT of v.
+// Since v is real, X[n-k] = -Im(e^(-i PI k / 2n) V[k]).
+//
+// DST-II(x)[k] = DCT-II(y)[n-1-k] with y[j] = (-1)^j x[j].
+void DCT::runDCT2(const double* x, double* out, bool sine) const {
+  const unsigned int n = this->n;
+  const unsigned int halfN = n >> 1;
+  const unsigned int halfMask = halfN - 1;
+  // The odd inputs, which go to the second half of v, change their sign
+  // for the DST.
+  const double oddSign = sine ? -1 : 1;
+
+  for (unsigned int i = 0; i < halfN; i++) {
+    const unsigned int j0 = 2 * i;
+    const unsigned int j1 = j0 + 1;
+    packed[i] = Complex(
+      j0 < halfN ? x[2 * j0] : oddSign * x[2 * n - 1 - 2 * j0],
+      j1 < halfN ? x[2 * j1] : oddSign * x[2 * n - 1 - 2 * j1]
+    );
+  }
+
+  run_fft(fft, packed, spectrum, 1);
+
+  const unsigned int outMask = sine ? n - 1 : 0;
+  for (unsigned int k = 0; k <= halfN; k++) {
+    // Split the DFT of the packed values into the DFTs of the even and the
+    // odd values of v.
+    const Complex z = spectrum[k & halfMask];
+    const Complex zc = conj(spectrum[(halfN - k) & halfMask]);
+    const Complex even = (z + zc) * 0.5;
+    const Complex odd = (z - zc) * Complex(0, -0.5);
+    const Complex u = shifts[k] * (even + twiddles[k] * odd);
+
+    out[k ^ outMask] = u.real();
+    if (k > 0 && k < halfN) {
+      out[(n - k) ^ outMask] = -u.imag();
+    }
+  }
+}
+
+// The inverse of runDCT2 (up to the factor n/2): recover V from X, compute
+// the inverse DFT of the packed v, and undo the reordering.
+//
+// DST-III(X)[j] = (-1)^j DCT-III(Y)[j] with Y[k] = X[n-1-k].
+void DCT::runDCT3(const double* x, double* out, bool sine) const {
+  const unsigned int n = this->n;
+  const unsigned int halfN = n >> 1;
+  const unsigned int inMask = sine ? n - 1 : 0;
+
+  // X[k] (or X[n-1-k] for the DST) and 0 for k = n
+#define input(k) ((k) < n ? x[(k) ^ inMask] : 0)
+#define spectrumV(k) (conj(shifts[k]) * Complex(input(k), -input(n - (k))))
+
+  for (unsigned int k = 0; k < halfN; k++) {
+    const Complex v = spectrumV(k);
+    const Complex vc = conj(spectrumV(halfN - k));
+    const Complex even = (v + vc) * 0.5;
+    const Complex odd = (v - vc) * conj(twiddles[k]) * 0.5;
+    packed[k] = even + Complex(-odd.imag(), odd.real());
+  }
+
+#undef spectrumV
+#undef input
+
+  run_fft(fft, packed, spectrum, -1);
+
+  const double oddSign = sine ? -1 : 1;
+  for (unsigned int i = 0; i < halfN; i++) {
+    const unsigned int j0 = 2 * i;
+    const unsigned int j1 = j0 + 1;
+    const Complex z = spectrum[i];
+    if (j0 < halfN) {
+      out[2 * j0] = z.real();
+    } else {
+      out[2 * n - 1 - 2 * j0] = oddSign * z.real();
+    }
+    if (j1 < halfN) {
+      out[2 * j1] = z.imag();
+    } else {
+      out[2 * n - 1 - 2 * j1] = oddSign * z.imag();
+    }
+  }
+}
+
+// With t[m] = (x[2m] + i x[n-1-2m]) e^(-i PI (4m+1) / 4n) and its DFT T,
+// u[k] = T[k] e^(-i PI k / n) gives X[2k] = Re(u[k]) and
+// X[n-1-2k] = -Im(u[k]).
+//
+// DST-IV(x)[k] = (-1)^k DCT-IV(y)[k] with y[j] = x[n-1-j].
+void DCT::runDCT4(const double* x, double* out, bool sine) const {
+  const unsigned int n = this->n;
+  const unsigned int halfN = n >> 1;
+  const unsigned int inMask = sine ? n - 1 : 0;
+
+  for (unsigned int i = 0; i < halfN; i++) {
+    const unsigned int j = 2 * i;
+    packed[i] = Complex(x[j ^ inMask], x[(n - 1 - j) ^ inMask]) * shifts[i];
+  }
+
+  run_fft(fft, packed, spectrum, 1);
+
+  // The odd outputs change their sign for the DST.
+  const double oddSign = sine ? 1 : -1;
+  for (unsigned int k = 0; k < halfN; k++) {
+    const Complex u = spectrum[k] * twiddles[k];
+    out[2 * k] = u.real();
+    out[n - 1 - 2 * k] = oddSign * u.imag();
+  }
+}
+
+MDCT::MDCT(unsigned int m, const double* window) : dct4(m, DCT_IV) {
+  const double PI = 3.14159265358979323846;
+  double* ownWindow = new double[2 * m];
+  for (unsigned int j = 0; j < 2 * m; j++) {
+    ownWindow[j] = window ? window[j] : sin(PI * (j + 0.5) / (2 * m));
+  }
+
+  this->m = m;
+  this->window = ownWindow;
+  this->history = new double[m];
+  this->overlap = new double[m];
+  this->folded = new double[m];
+  reset();
+}
+
+MDCT::~MDCT() {
+  delete[] window;
+  delete[] history;
+  delete[] overlap;
+  delete[] folded;
+}
+
+void MDCT::reset() {
+  for (unsigned int j = 0; j < m; j++) {
+    history[j] = 0;
+    overlap[j] = 0;
+  }
+}
+
+// The windowed frame f = (a, b, c, d) of 2m samples (quarters of m/2
+// values each) folds to (-c_r - d, a - b_r), where _r means reversed.
+void MDCT::forward(const double* samples, double* coefficients) {
+  const unsigned int m = this->m;
+  const unsigned int halfM = m >> 1;
+  const double* const w = window;
+
+#define frame(j) ((j) < m ? w[j] * history[j] : w[j] * samples[(j) - m])
+
+  for (unsigned int i = 0; i < halfM; i++) {
+    folded[i]         = -frame(3 * halfM - 1 - i) - frame(3 * halfM + i);
+    folded[halfM + i] =  frame(i) - frame(m - 1 - i);
+  }
+
+#undef frame
+
+  // (before the DCT in case `samples` and `coefficients` are the same)
+  for (unsigned int j = 0; j < m; j++) {
+    history[j] = samples[j];
+  }
+  dct4.run(folded, coefficients);
+}
+
+// The DCT-IV of the coefficients is (m/2) (u1, u2) for a folded frame
+// (u1, u2).  It unfolds to (u2, -u2_r, -u1_r, -u1), which after windowing
+// and overlapping cancels the aliasing of the neighbouring frames.
+void MDCT::inverse(const double* coefficients, double* samples) {
+  const unsigned int m = this->m;
+  const unsigned int halfM = m >> 1;
+  const double* const w = window;
+  const double scale = 2.0 / m;
+
+  dct4.run(coefficients, folded);
+
+  for (unsigned int j = 0; j < halfM; j++) {
+    samples[j] = overlap[j] + w[j] * scale * folded[halfM + j];
+  }
+  for (unsigned int j = halfM; j < m; j++) {
+    samples[j] = overlap[j] - w[j] * scale * folded[3 * halfM - 1 - j];
+  }
+  for (unsigned int j = m; j < 3 * halfM; j++) {
+    overlap[j - m] = -w[j] * scale * folded[3 * halfM - 1 - j];
+  }
+  for (unsigned int j = 3 * halfM; j < 2 * m; j++) {
+    overlap[j - m] = -w[j] * scale * folded[j - 3 * halfM];
+  }
+}
+
+extern "C" {
+  DCT* prepare_dct(unsigned int n, int kind) {
+    return new DCT(n, kind);
+  }
+
+  void run_dct(DCT* dct, const double* input, double* output) {
+    dct->run(input, output);
+  }
+
+  void delete_dct(DCT* dct) {
+    delete dct;
+  }
+
+  MDCT* prepare_mdct(unsigned int m, const double* window) {
+    return new MDCT(m, window);
+  }
+
+  void mdct_forward(MDCT* mdct, const double* samples, double* coefficients) {
+    mdct->forward(samples, coefficients);
+  }
+
+  void mdct_inverse(MDCT* mdct, const double* coefficients, double* samples) {
+    mdct->inverse(coefficients, samples);
+  }
+
+  void mdct_reset(MDCT* mdct) {
+    mdct->reset();
+  }
+
+  void delete_mdct(MDCT* mdct) {
+    delete mdct;
+  }
+}
@@ -0,0 +1,114 @@
+#ifndef DCT_HPP
+#define DCT_HPP 1
+
+#include "complex.h++"
+#include "c_bindings.h++"
+
+// Real-valued cosine and sine transforms of n points, computed with one
+// n/2-point complex FFT by the version this code is linked with.
+//
+// The transforms are unnormalized:
+//   DCT-II:  X[k] = sum_j x[j] cos(PI (2j+1) k / 2n)
+//   DCT-III: x[j] = X[0]/2 + sum_{k>0} X[k] cos(PI (2j+1) k / 2n)
+//   DCT-IV:  X[k] = sum_j x[j] cos(PI (2j+1) (2k+1) / 4n)
+//   DST-II:  X[k] = sum_j x[j] sin(PI (2j+1) (k+1) / 2n)
+//   DST-III: x[j] = (-1)^j X[n-1]/2 + sum_{k<n-1} X[k] sin(PI (2j+1) (k+1) / 2n)
+//   DST-IV:  X[k] = sum_j x[j] sin(PI (2j+1) (2k+1) / 4n)
+// So DCT-III inverts DCT-II, DST-III inverts DST-II, and DCT-IV and
+// DST-IV invert themselves, up to a factor of n/2.
+//
+// DCT-II and DCT-III use Makhoul's reordering: the even inputs followed by
+// the odd inputs in reverse order have a real DFT, which is computed by
+// the n/2-point FFT of the even and odd entries packed as complex numbers.
+// DCT-IV packs x[2m] + i x[n-1-2m] and multiplies by twiddle factors
+// before and after the n/2-point FFT.
+// The DSTs reverse the order and/or flip the signs of every other value
+// while packing and unpacking.
+//
+// n must be a power of 2 and at least 2.
+// Input and output may be the same array.
+
+#define DCT_II 0
+#define DCT_III 1
+#define DCT_IV 2
+#define DST_II 3
+#define DST_III 4
+#define DST_IV 5
+
+class DCT {
+  unsigned int n;
+  int kind;
+  FFT* fft;
+
+  // for 0 <= k <= n/2:
+  // - types II and III: shifts[k] = e^(-i PI k / 2n), twiddles[k] = e^(-i TAU k / n)
+  // - type IV: shifts[k] = e^(-i PI (4k+1) / 4n), twiddles[k] = e^(-i PI k / n)
+  Complex* shifts;
+  Complex* twiddles;
+
+  // pre-allocated buffers of n/2 complex numbers
+  Complex* packed;
+  Complex* spectrum;
+
+  void runDCT2(const double* x, double* out, bool sine) const;
+  void runDCT3(const double* x, double* out, bool sine) const;
+  void runDCT4(const double* x, double* out, bool sine) const;
+
+public:
+  DCT(unsigned int n, int kind);
+  ~DCT();
+
+  void run(const double* input, double* output) const;
+};
+
+// The modified DCT of overlapping blocks for streaming use.
+//
+// Each call of `forward` takes the next m samples and computes m
+// coefficients from the windowed last 2m samples:
+//   X[k] = sum_{j<2m} w[j] x[j] cos(PI/m (j + 1/2 + m/2) (k + 1/2))
+// This is a DCT-IV of m points after folding the 2m windowed samples.
+//
+// Each call of `inverse` takes m coefficients, unfolds their DCT-IV to 2m
+// samples, applies the window, adds the second half kept from the
+// previous call to the first half and returns that.  It includes the
+// factor 2/m, so if the window satisfies w[j]^2 + w[j+m]^2 = 1 (and is
+// symmetric), the inverse of the forward transforms reproduces the input,
+// delayed by m samples.
+//
+// A null window means the sine window w[j] = sin(PI (j + 1/2) / 2m).
+// m must be a power of 2 and at least 2.
+class MDCT {
+  unsigned int m;
+  double* window;
+  DCT dct4;
+
+  // the previous m input samples and the second half of the previous
+  // inverse block
+  double* history;
+  double* overlap;
+  // pre-allocated buffer of m values
+  double* folded;
+
+public:
+  MDCT(unsigned int m, const double* window);
+  ~MDCT();
+
+  void forward(const double* samples, double* coefficients);
+  void inverse(const double* coefficients, double* samples);
+  // Clear the history and the overlap (as in a newly created object).
+  void reset();
+};
+
+extern "C" {
+  DCT* prepare_dct(unsigned int n, int kind);
+  void run_dct(DCT* dct, const double* input, double* output);
+  void delete_dct(DCT* dct);
+
+  MDCT* prepare_mdct(unsigned int m, const double* window);
+  void mdct_forward(MDCT* mdct, const double* samples, double* coefficients);
+  void mdct_inverse(MDCT* mdct, const double* coefficients, double* samples);
+  void mdct_reset(MDCT* mdct);
+  void delete_mdct(MDCT* mdct);
+}
+
+#endif
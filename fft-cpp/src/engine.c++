@@ -0,0 +1,49 @@
+// One version compiled for the engine library (see engines.h++).
+//
+// The build defines FFT_ENGINE as the version name and FFT_ENGINE_SOURCE as
+// the quoted source file name, e.g., `-DFFT_ENGINE=fft47` and
+// `-DFFT_ENGINE_SOURCE="fft47.c++"`.
+//
+// The common headers (including the system headers used by the versions)
+// are included here, outside the namespace.  Their include guards keep the
+// version from including them again within the namespace.
+
+#include "buffers.h++"
+#include "complex.h++"
+#include "c_bindings.h++"
+#include "engines.h++"
+#include "postprocess.h++"
+#include "simd128.h++"
+#include "tables.h++"
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <complex>
+#include <vector>
+
+#define ENGINE_STRING(name) #name
+#define ENGINE_NAME(name) ENGINE_STRING(name)
+
+namespace FFT_ENGINE {
+
+#include FFT_ENGINE_SOURCE
+
+  static FFTPlan* prepareEngine(unsigned int n) {
+    return (FFTPlan*) prepare_fft(n);
+  }
+
+  static void runEngine(FFTPlan* plan, const Complex* input, Complex* output, int direction) {
+    run_fft((FFT*) plan, input, output, direction);
+  }
+
+  static void destroyEngine(FFTPlan* plan) {
+    delete_fft((FFT*) plan);
+  }
+
+  extern const FFTEngine engine = {
+    ENGINE_NAME(FFT_ENGINE), prepareEngine, runEngine, destroyEngine,
+  };
+}
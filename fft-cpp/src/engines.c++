@@ -0,0 +1,36 @@
+#include "engines.h++"
+#include <string.h>
+
+#ifndef FFT_ENGINES
+#error "FFT_ENGINES must be defined by the build (see engines.h++)"
+#endif
+
+// The engines are defined by the translation units compiled from engine.c++.
+#define DECLARE_ENGINE(name) namespace name { extern const FFTEngine engine; }
+FFT_ENGINES(DECLARE_ENGINE)
+#undef DECLARE_ENGINE
+
+#define ENGINE_ADDRESS(name) &name::engine,
+static const FFTEngine* const engines[] = { FFT_ENGINES(ENGINE_ADDRESS) };
+#undef ENGINE_ADDRESS
+
+static const unsigned int nEngines = sizeof(engines) / sizeof(engines[0]);
+
+extern "C" {
+  const FFTEngine* fft_engine_by_name(const char* name) {
+    for (unsigned int i = 0; i < nEngines; i++) {
+      if (strcmp(engines[i]->name, name) == 0) {
+        return engines[i];
+      }
+    }
+    return 0;
+  }
+
+  unsigned int fft_engine_count() {
+    return nEngines;
+  }
+
+  const FFTEngine* fft_engine_at(unsigned int i) {
+    return i < nEngines ? engines[i] : 0;
+  }
+}
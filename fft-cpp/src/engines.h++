@@ -0,0 +1,42 @@
+#ifndef ENGINES_HPP
+#define ENGINES_HPP 1
+
+#include "complex.h++"
+
+// All versions linked into one library (libfft.a/libfft.so, built by
+// `TECH=NATIVE scripts/compile.mjs`).
+//
+// Every version defines its own `FFT` class and C API.  For the library,
+// each version is compiled within a namespace of the same name (see
+// engine.c++), and the registry below gives access to it by name.  The
+// functions of an engine call the version's C functions, which are inlined
+// there, so using an engine costs one indirect call per transform.
+
+// The versions in the library are listed by the macro FFT_ENGINES(X),
+// which expands X(version) for each of them.  The build defines it for
+// engines.c++ from the versions found in src/ (`allVersions` in
+// scripts/compile.mjs), so that the registry cannot miss a version.
+
+// A plan of any engine.  It must only be passed to the engine that created it.
+struct FFTPlan;
+
+struct FFTEngine {
+  // the version name
+  const char* name;
+  // These correspond to prepare_fft, run_fft, and delete_fft of the version.
+  FFTPlan* (*prepare)(unsigned int n);
+  void (*run)(FFTPlan* plan, const Complex* input, Complex* output, int direction);
+  void (*destroy)(FFTPlan* plan);
+};
+
+extern "C" {
+  // The engine for a version name or a null pointer for an unknown name.
+  const FFTEngine* fft_engine_by_name(const char* name);
+
+  // Enumerate the engines: the engine with index i < fft_engine_count()
+  // (or a null pointer for a larger index).
+  unsigned int fft_engine_count();
+  const FFTEngine* fft_engine_at(unsigned int i);
+}
+
+#endif
@@ -1,167 +1,349 @@
 #include "fft47.h++"
+#include "buffers.h++"
 #include "complex.h++"
-#include "fallbackFFT.h++"
+#include "c_bindings.h++"
+#include "cobra.h++"
+#include "postprocess.h++"
+#include "simd128.h++"
+#include "tables.h++"
 #include <math.h>
 
-const double TAU = 6.2831853071795864769;
-
 FFT::FFT(unsigned int n) {
   double* cosines = new double[n];
-  for (unsigned int i = 0; i < n; i++) {
-    cosines[i] = cos(TAU * i / n);
-  }
+  fillCosines(cosines, n, n);
 
   const unsigned int quarterN = n >> 2;
   unsigned int* permute = new unsigned int[quarterN];
-  for (unsigned int i = 0; i < quarterN; i++) {
-    permute[i] = 0;
-  }
-  for (unsigned int len = quarterN, fStride = 1; len > 1; len >>= 1, fStride <<= 1) {
-    unsigned int halfLen = len >> 1;
-    for (unsigned int out_offset = 0; out_offset < quarterN; out_offset += len) {
-      unsigned int limit = out_offset + len;
-      for (unsigned int out_offset_odd = out_offset + halfLen; out_offset_odd < limit; out_offset_odd++) {
-        permute[out_offset_odd] += fStride;
-      }
-    }
-  }
+  fillBitReversal(permute, quarterN, quarterN);
 
   this->n = n;
   this->cosines = cosines;
   this->permute = permute;
+  this->outputMode = FFT_OUTPUT_COMPLEX;
+  this->forwardScale = 1;
+  this->inverseScale = 1;
+  this->scratch = 0;
+  this->image = 0;
 }
 
 FFT::~FFT() {
-  delete cosines;
-  delete permute;
+  if (image) {
+    unmapPlanImage(image);
+    delete image;
+  } else {
+    delete[] cosines;
+    delete[] permute;
+  }
+  delete[] scratch;
 }
 
-void FFT::run(const Complex* f, Complex* out, int direction) const {
+// See tables.h++.
+static const char planEngine[] = "fft47";
+
+FFT::FFT(PlanImage* image) {
+  // The tables are mapped read-only, but run() does not write them anyway.
+  this->n = image->n;
+  this->cosines = (double*) image->cosines;
+  this->permute = (unsigned int*) image->permute;
+  this->outputMode = FFT_OUTPUT_COMPLEX;
+  this->forwardScale = 1;
+  this->inverseScale = 1;
+  this->scratch = 0;
+  this->image = image;
+}
+
+FFT* FFT::load(const char* path) {
+  PlanImage* image = new PlanImage;
+  if (mapPlanImage(path, planEngine, image) != 0) {
+    delete image;
+    return 0;
+  }
+  const unsigned int n = image->n;
+  if (image->nCosines != n || image->nPermute != n >> 2) {
+    unmapPlanImage(image);
+    delete image;
+    return 0;
+  }
+  return new FFT(image);
+}
+
+int FFT::save(const char* path) const {
+  return writePlanImage(path, planEngine, n, cosines, n, permute, n >> 2);
+}
+
+// Post-processing (see postprocess.h++) is fused into the last stage:
+// All stages but the last one store their results with a `WorkStore`,
+// the last one with the output selected by `run`.
+struct WorkStore {
+  Complex* work;
+  inline void operator()(unsigned int i, VComplex z) const {
+    vstore(work + i, z);
+  }
+};
+
+#define rotation(x) vcomplex(cosines[(x) & nMask], cosines[(quarterN - (x)) & nMask])
+
+template <class Store>
+void FFT::firstPass(const Complex* f, int direction, Store store) const {
   const unsigned int n = this->n;
-  fallbackFFT(n, f, out);
-  double* const cosines = this->cosines;
-  unsigned int* const permute = this->permute;
+  const unsigned int* const permute = this->permute;
+  const unsigned int quarterN = n >> 2;
+  const double negDirection = -direction;
+
+  // b0, ..., b3 are the inputs for the outputs out_offset, ..., out_offset + 3
+  // in bit-reversed order.
+  auto butterfly = [&](unsigned int out_offset, VComplex b0, VComplex b1, VComplex b2, VComplex b3) {
+    const VComplex c0 =       b0 + b1;
+    const VComplex c1 =       b0 - b1;
+    const VComplex c2 =       b2 + b3;
+    const VComplex c3 = rot90(b2 - b3) * negDirection;
 
+    store(out_offset++, c0 + c2);
+    store(out_offset++, c1 + c3);
+    store(out_offset++, c0 - c2);
+    store(out_offset++, c1 - c3);
+  };
+
+  if (n >= cobraMinN) {
+    bitReversedGroups(f, n, 4, [&](unsigned int out_offset, const Complex* x) {
+      butterfly(out_offset, vload(x), vload(x + 1), vload(x + 2), vload(x + 3));
+    });
+    return;
+  }
+
+  for (unsigned int out_offset = 0; out_offset < n; out_offset += 4) {
+    unsigned int offset = permute[out_offset >> 2];
+    const VComplex b0 = vload(f + offset); offset += quarterN;
+    const VComplex b2 = vload(f + offset); offset += quarterN;
+    const VComplex b1 = vload(f + offset); offset += quarterN;
+    const VComplex b3 = vload(f + offset);
+    butterfly(out_offset, b0, b1, b2, b3);
+  }
+}
+
+template <class Store>
+void FFT::radix4Stage(Complex* work, unsigned int len, int rStride, int direction, Store store) const {
+  const unsigned int n = this->n;
+  const double* const cosines = this->cosines;
   const unsigned int nMask = n - 1;
   const unsigned int quarterN = n >> 2;
   const double negDirection = -direction;
 
-#define rotation(x) Complex(cosines[(x) & nMask], cosines[(quarterN - (x)) & nMask])
+  const unsigned int halfLen = len >> 1;
+  // We have pulled out and simplified the case k = 0.
+  // TODO Also pull out the case k = quarterLen?
+  // r1, r2, and r3 will be -1/8, -2/8, and -3/8 of a full turn, which
+  // allows to simplify the expressions for b1, b2, and b3.
+  // (But it will not get as simple as the case k = 0.  So I am not sure
+  // if it is worthwhile.)
+  {
+    for (unsigned int out_offset = 0; out_offset < n;) {
+      unsigned int i0 = out_offset; out_offset += halfLen;
+      unsigned int i1 = out_offset; out_offset += halfLen;
+      unsigned int i2 = out_offset; out_offset += halfLen;
+      unsigned int i3 = out_offset; out_offset += halfLen;
 
-  for (unsigned int out_offset = 0; out_offset < n;) {
-    unsigned int offset = permute[out_offset >> 2];
-    const Complex b0 = f[offset]; offset += quarterN;
-    const Complex b2 = f[offset]; offset += quarterN;
-    const Complex b1 = f[offset]; offset += quarterN;
-    const Complex b3 = f[offset];
+      const VComplex b0 = vload(work + i0);
+      const VComplex b1 = vload(work + i1);
+      const VComplex b2 = vload(work + i2);
+      const VComplex b3 = vload(work + i3);
+
+      const VComplex c0 =       b0 + b1;
+      const VComplex c1 =       b0 - b1;
+      const VComplex c2 =       b2 + b3;
+      const VComplex c3 = rot90(b2 - b3) * negDirection;
+
+      store(i0, c0 + c2);
+      store(i1, c1 + c3);
+      store(i2, c0 - c2);
+      store(i3, c1 - c3);
+    }
+  }
+  const int rStride1 = rStride >> 1;
+  const int rStride2 = rStride;
+  const int rStride3 = rStride2 + rStride1;
+  int rOffset1 = -rStride1;
+  int rOffset2 = -rStride2;
+  int rOffset3 = -rStride3;
+  for (unsigned int k = 1; k < halfLen; k++) {
+    // TODO Some bit fiddling with rOffset[123] to restrict cosine lookups
+    // to the first quadrant?  Then shorten the cosines array.
+    const VComplex r1 = rotation(rOffset1); rOffset1 -= rStride1;
+    const VComplex r2 = rotation(rOffset2); rOffset2 -= rStride2;
+    const VComplex r3 = rotation(rOffset3); rOffset3 -= rStride3;
+    for (unsigned int out_offset = k; out_offset < n;) {
+      unsigned int i0 = out_offset; out_offset += halfLen;
+      unsigned int i1 = out_offset; out_offset += halfLen;
+      unsigned int i2 = out_offset; out_offset += halfLen;
+      unsigned int i3 = out_offset; out_offset += halfLen;
 
-    const Complex c0 =       b0 + b1;
-    const Complex c1 =       b0 - b1;
-    const Complex c2 =       b2 + b3;
-    const Complex c3 = rot90(b2 - b3) * negDirection;
+      const VComplex b0 = vload(work + i0);
+      const VComplex b1 = vload(work + i1) * r2;
+      const VComplex b2 = vload(work + i2) * r1;
+      const VComplex b3 = vload(work + i3) * r3;
 
-    out[out_offset++] = c0 + c2;
-    out[out_offset++] = c1 + c3;
-    out[out_offset++] = c0 - c2;
-    out[out_offset++] = c1 - c3;
+      const VComplex c0 =       b0 + b1;
+      const VComplex c1 =       b0 - b1;
+      const VComplex c2 =       b2 + b3;
+      const VComplex c3 = rot90(b2 - b3) * negDirection;
+
+      store(i0, c0 + c2);
+      store(i1, c1 + c3);
+      store(i2, c0 - c2);
+      store(i3, c1 - c3);
+    }
+  }
+}
+
+template <class Store>
+void FFT::radix2Stage(Complex* work, int rStride, Store store) const {
+  const unsigned int n = this->n;
+  const double* const cosines = this->cosines;
+  const unsigned int nMask = n - 1;
+  const unsigned int quarterN = n >> 2;
+  const unsigned int halfLen = n >> 1;
+
+  // TODO Roll this back into the following loop?
+  // Saving a single complex multiplicatin is probably not worth the extra code.
+  {
+    const VComplex z0 = vload(work          );
+    const VComplex z1 = vload(work + halfLen);
+
+    store(0      , z0 + z1);
+    store(halfLen, z0 - z1);
+  }
+  int rOffset = -rStride;
+  for (unsigned int k0 = 1, k1 = halfLen + 1; k0 < halfLen; k0++, k1++) {
+    const VComplex r = rotation(rOffset); rOffset -= rStride;
+
+    const VComplex z0 = vload(work + k0);
+    const VComplex z1 = vload(work + k1) * r;
+
+    store(k0, z0 + z1);
+    store(k1, z0 - z1);
+  }
+}
+
+#undef rotation
+
+template <class Output>
+void FFT::runWith(const Complex* f, Complex* work, int direction, Output output) const {
+  const unsigned int n = this->n;
+  switch (n) {
+    case 1: {
+      output(0, vload(f));
+      return;
+    }
+    case 2: {
+      const VComplex z0 = vload(f);
+      const VComplex z1 = vload(f + 1);
+      output(0, z0 + z1);
+      output(1, z0 - z1);
+      return;
+    }
+    case 4: {
+      firstPass(f, direction, output);
+      return;
+    }
+  }
+
+  const WorkStore toWork{work};
+  if (n >= cobraMinN) {
+    const CobraStore toWorkFirst{work};
+    firstPass(f, direction, toWorkFirst);
+    toWorkFirst.finish();
+  } else {
+    firstPass(f, direction, toWork);
   }
 
   unsigned int len = 8;
   int rStride = direction * (n >> 3);
   for (; len < n; len <<= 2, rStride >>= 2) {
-    const unsigned int halfLen = len >> 1;
-    // We have pulled out and simplified the case k = 0.
-    // TODO Also pull out the case k = quarterLen?
-    // r1, r2, and r3 will be -1/8, -2/8, and -3/8 of a full turn, which
-    // allows to simplify the expressions for b1, b2, and b3.
-    // (But it will not get as simple as the case k = 0.  So I am not sure
-    // if it is worthwhile.)
-    {
-      for (unsigned int out_offset = 0; out_offset < n;) {
-        unsigned int i0 = out_offset; out_offset += halfLen;
-        unsigned int i1 = out_offset; out_offset += halfLen;
-        unsigned int i2 = out_offset; out_offset += halfLen;
-        unsigned int i3 = out_offset; out_offset += halfLen;
-
-        const Complex b0 = out[i0];
-        const Complex b1 = out[i1];
-        const Complex b2 = out[i2];
-        const Complex b3 = out[i3];
-
-        const Complex c0 =       b0 + b1;
-        const Complex c1 =       b0 - b1;
-        const Complex c2 =       b2 + b3;
-        const Complex c3 = rot90(b2 - b3) * negDirection;
-
-        out[i0] = c0 + c2;
-        out[i1] = c1 + c3;
-        out[i2] = c0 - c2;
-        out[i3] = c1 - c3;
-      }
-    }
-    const int rStride1 = rStride >> 1;
-    const int rStride2 = rStride;
-    const int rStride3 = rStride2 + rStride1;
-    int rOffset1 = -rStride1;
-    int rOffset2 = -rStride2;
-    int rOffset3 = -rStride3;
-    for (unsigned int k = 1; k < halfLen; k++) {
-      // TODO Some bit fiddling with rOffset[123] to restrict cosine lookups
-      // to the first quadrant?  Then shorten the cosines array.
-      const Complex r1 = rotation(rOffset1); rOffset1 -= rStride1;
-      const Complex r2 = rotation(rOffset2); rOffset2 -= rStride2;
-      const Complex r3 = rotation(rOffset3); rOffset3 -= rStride3;
-      for (unsigned int out_offset = k; out_offset < n;) {
-        unsigned int i0 = out_offset; out_offset += halfLen;
-        unsigned int i1 = out_offset; out_offset += halfLen;
-        unsigned int i2 = out_offset; out_offset += halfLen;
-        unsigned int i3 = out_offset; out_offset += halfLen;
-
-        const Complex b0 = out[i0];
-        const Complex b1 = out[i1] * r2;
-        const Complex b2 = out[i2] * r1;
-        const Complex b3 = out[i3] * r3;
-
-        const Complex c0 =       b0 + b1;
-        const Complex c1 =       b0 - b1;
-        const Complex c2 =       b2 + b3;
-        const Complex c3 = rot90(b2 - b3) * negDirection;
-
-        out[i0] = c0 + c2;
-        out[i1] = c1 + c3;
-        out[i2] = c0 - c2;
-        out[i3] = c1 - c3;
-      }
+    if (len << 1 == n) {
+      radix4Stage(work, len, rStride, direction, output);
+    } else {
+      radix4Stage(work, len, rStride, direction, toWork);
     }
   }
   if (len == n) {
     // If we come here, n is not a power of 4 (but still a power of 2).
     // So we need to run one extra round of 2-way butterflies.
-    const unsigned int halfLen = len >> 1;
-
-    // TODO Roll this back into the following loop?
-    // Saving a single complex multiplicatin is probably not worth the extra code.
-    {
-      const Complex z0 = out[0      ];
-      const Complex z1 = out[halfLen];
+    radix2Stage(work, rStride, output);
+  }
+}
 
-      out[0      ] = z0 + z1;
-      out[halfLen] = z0 - z1;
-    }
-    int rOffset = -rStride;
-    for (unsigned int k0 = 1, k1 = halfLen + 1; k0 < halfLen; k0++, k1++) {
-      const Complex r = rotation(rOffset); rOffset -= rStride;
+void FFT::run(const Complex* f, Complex* out, int direction) const {
+  run(f, out, direction, scratch);
+}
 
-      const Complex z0 = out[k0];
-      const Complex z1 = out[k1] * r;
+void FFT::run(const Complex* f, Complex* out, int direction, Complex* scratch) const {
+  const double scale = direction > 0 ? forwardScale : inverseScale;
+  // The real-valued modes write to `out` what they have read from `scratch`.
+  // So they also work in place.
+  Complex* const work = outputMode == FFT_OUTPUT_COMPLEX ? out : scratch;
+  withOutput(outputMode, scale, out, [&](auto output) {
+    runWith(f, work, direction, output);
+  });
+}
 
-      out[k0] = z0 + z1;
-      out[k1] = z0 - z1;
-    }
+int FFT::setOutput(int mode, double forwardScale, double inverseScale) {
+  if (mode < FFT_OUTPUT_COMPLEX || mode > FFT_OUTPUT_LOG_POWER) {
+    return -1;
   }
+  if (mode != FFT_OUTPUT_COMPLEX && !scratch) {
+    scratch = new Complex[n];
+  }
+  this->outputMode = mode;
+  this->forwardScale = forwardScale;
+  this->inverseScale = inverseScale;
+  return 0;
+}
 
-#undef rotation
+PlanBuffers& FFT::getBuffers() {
+  buffers.allocate(n);
+  return buffers;
+}
+
+bool FFT::setInputs(const double* re, const double* im) {
+  return buffers.setInputs(n, re, im);
+}
 
+bool FFT::getOutputs(double* re, double* im) {
+  return buffers.getOutputs(n, outputMode != FFT_OUTPUT_COMPLEX, re, im);
 }
 
+FFT_C_API_BEGIN
+  int set_fft_output(FFT* fft, int mode, double forwardScale, double inverseScale) {
+    return fft->setOutput(mode, forwardScale, inverseScale);
+  }
+
+  void run_fft_with_work(FFT* fft, const Complex* input, Complex* output, int direction, Complex* work) {
+    fft->run(input, output, direction, work);
+  }
+
+  int save_fft_plan(const FFT* fft, const char* path) {
+    return fft->save(path);
+  }
+
+  FFT* load_fft_plan(const char* path) {
+    return FFT::load(path);
+  }
+
+  Complex* fft_input_buffer(FFT* fft) {
+    return fft->getBuffers().input;
+  }
+
+  Complex* fft_output_buffer(FFT* fft) {
+    return fft->getBuffers().output;
+  }
+
+  int fft_set_inputs(FFT* fft, const double* re, const double* im) {
+    return fft->setInputs(re, im) ? 0 : -1;
+  }
+
+  int fft_get_outputs(FFT* fft, double* re, double* im) {
+    return fft->getOutputs(re, im) ? 0 : -1;
+  }
+FFT_C_API_END
+
 #include "c_bindings.c++"
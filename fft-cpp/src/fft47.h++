@@ -1,18 +1,54 @@
 #ifndef FFT47_HPP
 #define FFT47_HPP 1
 
+#include "buffers.h++"
 #include "complex.h++"
+#include "tables.h++"
 
 class FFT {
   unsigned int n;
   double* cosines;
   unsigned int* permute;
 
+  // see postprocess.h++
+  int outputMode;
+  double forwardScale;
+  double inverseScale;
+  Complex* scratch;
+
+  // the mapped plan image (see tables.h++) or a null pointer if the tables
+  // have been computed
+  PlanImage* image;
+  FFT(PlanImage* image);
+
+  // see buffers.h++
+  PlanBuffers buffers;
+
+  template <class Store>
+  void firstPass(const Complex* f, int direction, Store store) const;
+  template <class Store>
+  void radix4Stage(Complex* work, unsigned int len, int rStride, int direction, Store store) const;
+  template <class Store>
+  void radix2Stage(Complex* work, int rStride, Store store) const;
+  template <class Output>
+  void runWith(const Complex* f, Complex* work, int direction, Output output) const;
+
 public:
   FFT(unsigned int n);
   ~FFT();
 
   void run(const Complex* f, Complex* out, int direction = 1) const;
+  // The real-valued output modes use `scratch` (n entries) instead of the
+  // plan's own work area.
+  void run(const Complex* f, Complex* out, int direction, Complex* scratch) const;
+  int setOutput(int mode, double forwardScale, double inverseScale);
+
+  PlanBuffers& getBuffers();
+  bool setInputs(const double* re, const double* im);
+  bool getOutputs(double* re, double* im);
+
+  static FFT* load(const char* path);
+  int save(const char* path) const;
 };
 
 #endif
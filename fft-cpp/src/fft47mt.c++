@@ -0,0 +1,256 @@
+#include "fft47mt.h++"
+#include "complex.h++"
+#include "fallbackFFT.h++"
+#include "simd128.h++"
+#include "tables.h++"
+#include <math.h>
+
+FFT::FFT(unsigned int n) {
+  double* cosines = new double[n];
+  fillCosines(cosines, n, n);
+
+  const unsigned int quarterN = n >> 2;
+  unsigned int* permute = new unsigned int[quarterN];
+  fillBitReversal(permute, quarterN, quarterN);
+
+  this->n = n;
+  this->cosines = cosines;
+  this->permute = permute;
+}
+
+FFT::~FFT() {
+  delete[] cosines;
+  delete[] permute;
+}
+
+#define rotation(x) vcomplex(cosines[(x) & nMask], cosines[(quarterN - (x)) & nMask])
+
+// The size of the blocks computed independently in step 0.
+// This is the largest power of 4 giving at least nParts blocks.
+// If there is not enough work for nParts blocks, return n, which means
+// that the entire transformation is done sequentially in step 0.
+unsigned int FFT::blockSize(unsigned int nParts) const {
+  const unsigned int n = this->n;
+  if (nParts <= 1 || n / 4 < nParts) {
+    return n;
+  }
+  unsigned int size = 4;
+  while (n / (size * 4) >= nParts) {
+    size *= 4;
+  }
+  return size;
+}
+
+// The first pass and all stages that stay within out[begin .. begin+size).
+// If size == n, this is the entire transformation.
+void FFT::runBlock(const Complex* f, Complex* out, int direction, unsigned int begin, unsigned int size) const {
+  unsigned int* const permute = this->permute;
+  const unsigned int quarterN = n >> 2;
+  const unsigned int end = begin + size;
+  const double negDirection = -direction;
+
+  for (unsigned int out_offset = begin; out_offset < end;) {
+    unsigned int offset = permute[out_offset >> 2];
+    const VComplex b0 = vload(f + offset); offset += quarterN;
+    const VComplex b2 = vload(f + offset); offset += quarterN;
+    const VComplex b1 = vload(f + offset); offset += quarterN;
+    const VComplex b3 = vload(f + offset);
+
+    const VComplex c0 =       b0 + b1;
+    const VComplex c1 =       b0 - b1;
+    const VComplex c2 =       b2 + b3;
+    const VComplex c3 = rot90(b2 - b3) * negDirection;
+
+    vstore(out + out_offset++, c0 + c2);
+    vstore(out + out_offset++, c1 + c3);
+    vstore(out + out_offset++, c0 - c2);
+    vstore(out + out_offset++, c1 - c3);
+  }
+
+  unsigned int len = 8;
+  for (; len < n && 2 * len <= size; len <<= 2) {
+    runStage(out, direction, len, 0, len >> 1, begin, end);
+  }
+  if (len == n && size == n) {
+    runLastStage(out, direction, 0, n >> 1);
+  }
+}
+
+// The 4-way butterflies of the stage combining blocks of size len/2
+// for k in [kBegin, kEnd) and output offsets in [begin, end).
+void FFT::runStage(
+  Complex* out, int direction, unsigned int len,
+  unsigned int kBegin, unsigned int kEnd,
+  unsigned int begin, unsigned int end
+) const {
+  double* const cosines = this->cosines;
+  const unsigned int nMask = n - 1;
+  const unsigned int quarterN = n >> 2;
+  const double negDirection = -direction;
+
+  const unsigned int halfLen = len >> 1;
+  const int rStride = direction * (int) (n / len);
+  unsigned int k = kBegin;
+  if (k == 0 && k < kEnd) {
+    for (unsigned int out_offset = begin; out_offset < end;) {
+      unsigned int i0 = out_offset; out_offset += halfLen;
+      unsigned int i1 = out_offset; out_offset += halfLen;
+      unsigned int i2 = out_offset; out_offset += halfLen;
+      unsigned int i3 = out_offset; out_offset += halfLen;
+
+      const VComplex b0 = vload(out + i0);
+      const VComplex b1 = vload(out + i1);
+      const VComplex b2 = vload(out + i2);
+      const VComplex b3 = vload(out + i3);
+
+      const VComplex c0 =       b0 + b1;
+      const VComplex c1 =       b0 - b1;
+      const VComplex c2 =       b2 + b3;
+      const VComplex c3 = rot90(b2 - b3) * negDirection;
+
+      vstore(out + i0, c0 + c2);
+      vstore(out + i1, c1 + c3);
+      vstore(out + i2, c0 - c2);
+      vstore(out + i3, c1 - c3);
+    }
+    k = 1;
+  }
+  const int rStride1 = rStride >> 1;
+  const int rStride2 = rStride;
+  const int rStride3 = rStride2 + rStride1;
+  int rOffset1 = -(int) k * rStride1;
+  int rOffset2 = -(int) k * rStride2;
+  int rOffset3 = -(int) k * rStride3;
+  for (; k < kEnd; k++) {
+    const VComplex r1 = rotation(rOffset1); rOffset1 -= rStride1;
+    const VComplex r2 = rotation(rOffset2); rOffset2 -= rStride2;
+    const VComplex r3 = rotation(rOffset3); rOffset3 -= rStride3;
+    for (unsigned int out_offset = begin + k; out_offset < end;) {
+      unsigned int i0 = out_offset; out_offset += halfLen;
+      unsigned int i1 = out_offset; out_offset += halfLen;
+      unsigned int i2 = out_offset; out_offset += halfLen;
+      unsigned int i3 = out_offset; out_offset += halfLen;
+
+      const VComplex b0 = vload(out + i0);
+      const VComplex b1 = vload(out + i1) * r2;
+      const VComplex b2 = vload(out + i2) * r1;
+      const VComplex b3 = vload(out + i3) * r3;
+
+      const VComplex c0 =       b0 + b1;
+      const VComplex c1 =       b0 - b1;
+      const VComplex c2 =       b2 + b3;
+      const VComplex c3 = rot90(b2 - b3) * negDirection;
+
+      vstore(out + i0, c0 + c2);
+      vstore(out + i1, c1 + c3);
+      vstore(out + i2, c0 - c2);
+      vstore(out + i3, c1 - c3);
+    }
+  }
+}
+
+// The extra round of 2-way butterflies if n is not a power of 4,
+// for k in [kBegin, kEnd).
+void FFT::runLastStage(Complex* out, int direction, unsigned int kBegin, unsigned int kEnd) const {
+  double* const cosines = this->cosines;
+  const unsigned int nMask = n - 1;
+  const unsigned int quarterN = n >> 2;
+  const unsigned int halfLen = n >> 1;
+
+  unsigned int k0 = kBegin;
+  if (k0 == 0 && k0 < kEnd) {
+    const VComplex z0 = vload(out          );
+    const VComplex z1 = vload(out + halfLen);
+
+    vstore(out          , z0 + z1);
+    vstore(out + halfLen, z0 - z1);
+    k0 = 1;
+  }
+  int rOffset = -(int) k0 * direction;
+  for (unsigned int k1 = halfLen + k0; k0 < kEnd; k0++, k1++) {
+    const VComplex r = rotation(rOffset); rOffset -= direction;
+
+    const VComplex z0 = vload(out + k0);
+    const VComplex z1 = vload(out + k1) * r;
+
+    vstore(out + k0, z0 + z1);
+    vstore(out + k1, z0 - z1);
+  }
+}
+
+#undef rotation
+
+void FFT::run(const Complex* f, Complex* out, int direction) const {
+  fallbackFFT(n, f, out);
+  runBlock(f, out, direction, 0, n);
+}
+
+unsigned int FFT::parallelSteps(unsigned int nParts) const {
+  const unsigned int size = blockSize(nParts);
+  if (size == n) {
+    return 1;
+  }
+  unsigned int steps = 1;
+  unsigned int len = 8;
+  for (; len < n; len <<= 2) {
+    if (2 * len > size) {
+      steps++;
+    }
+  }
+  if (len == n) {
+    steps++;
+  }
+  return steps;
+}
+
+void FFT::runParallel(
+  const Complex* f, Complex* out, int direction,
+  unsigned int step, unsigned int part, unsigned int nParts
+) const {
+  const unsigned int size = blockSize(nParts);
+  if (step == 0) {
+    if (size == n) {
+      if (part == 0) {
+        run(f, out, direction);
+      }
+    } else {
+      for (unsigned int begin = part * size; begin < n; begin += nParts * size) {
+        runBlock(f, out, direction, begin, size);
+      }
+    }
+    return;
+  }
+
+  // Find the stage for this step.
+  unsigned int len = 8;
+  while (2 * len <= size) {
+    len <<= 2;
+  }
+  for (unsigned int i = 1; i < step; i++) {
+    len <<= 2;
+  }
+  // Split the k range evenly among the parts.
+  const unsigned int nk = len < n ? len >> 1 : n >> 1;
+  const unsigned int kBegin = (unsigned long long) nk * part / nParts;
+  const unsigned int kEnd = (unsigned long long) nk * (part + 1) / nParts;
+  if (len < n) {
+    runStage(out, direction, len, kBegin, kEnd, 0, n);
+  } else {
+    runLastStage(out, direction, kBegin, kEnd);
+  }
+}
+
+FFT_C_API_BEGIN
+  unsigned int fft_parallel_steps(FFT* fft, unsigned int nParts) {
+    return fft->parallelSteps(nParts);
+  }
+
+  void run_fft_parallel(
+    FFT* fft, const Complex* input, Complex* output, int direction,
+    unsigned int step, unsigned int part, unsigned int nParts
+  ) {
+    fft->runParallel(input, output, direction, step, part, nParts);
+  }
+FFT_C_API_END
+
+#include "c_bindings.c++"
@@ -0,0 +1,51 @@
+#ifndef FFT47MT_HPP
+#define FFT47MT_HPP 1
+
+#include "complex.h++"
+#include "c_bindings.h++"
+
+// fft47 with entry points for splitting a transformation among threads.
+//
+// A parallel run consists of `parallelSteps(nParts)` steps.
+// In each step every part (0 <= part < nParts) calls `runParallel` and all
+// parts must have finished a step before any part starts the next step.
+// - Step 0 computes the first stages independently on blocks of the output
+//   array.  Each part handles every nParts-th block.
+// - Each further step computes one of the remaining stages.  Each part
+//   handles a contiguous range of rotations.
+class FFT {
+  unsigned int n;
+  double* cosines;
+  unsigned int* permute;
+
+  unsigned int blockSize(unsigned int nParts) const;
+  void runBlock(const Complex* f, Complex* out, int direction, unsigned int begin, unsigned int size) const;
+  void runStage(
+    Complex* out, int direction, unsigned int len,
+    unsigned int kBegin, unsigned int kEnd,
+    unsigned int begin, unsigned int end
+  ) const;
+  void runLastStage(Complex* out, int direction, unsigned int kBegin, unsigned int kEnd) const;
+
+public:
+  FFT(unsigned int n);
+  ~FFT();
+
+  void run(const Complex* f, Complex* out, int direction = 1) const;
+
+  unsigned int parallelSteps(unsigned int nParts) const;
+  void runParallel(
+    const Complex* f, Complex* out, int direction,
+    unsigned int step, unsigned int part, unsigned int nParts
+  ) const;
+};
+
+FFT_C_API_BEGIN
+  unsigned int fft_parallel_steps(FFT* fft, unsigned int nParts);
+  void run_fft_parallel(
+    FFT* fft, const Complex* input, Complex* output, int direction,
+    unsigned int step, unsigned int part, unsigned int nParts
+  );
+FFT_C_API_END
+
+#endif
@@ -0,0 +1,230 @@
+#include "fft47pruned.h++"
+#include "complex.h++"
+#include "fallbackFFT.h++"
+#include "simd128.h++"
+#include "tables.h++"
+#include <math.h>
+
+FFT::FFT(unsigned int n, unsigned int nonZeroInputs, unsigned int outStart, unsigned int outCount) {
+  double* cosines = new double[n];
+  fillCosines(cosines, n, n);
+
+  const unsigned int quarterN = n >> 2;
+  unsigned int* permute = new unsigned int[quarterN];
+  fillBitReversal(permute, quarterN, quarterN);
+
+  this->n = n;
+  this->cosines = cosines;
+  this->permute = permute;
+  this->nonZeroInputs = nonZeroInputs < n ? nonZeroInputs : n;
+  this->outStart = outStart & (n - 1);
+  this->outCount = outCount < n ? outCount : n;
+}
+
+FFT::~FFT() {
+  delete[] cosines;
+  delete[] permute;
+}
+
+// Pruning works like this:
+//
+// After the first pass and after each stage, out consists of blocks.
+// The block of size S at offset o is the DFT of the inputs with indices
+// congruent to permute[o >> 2] modulo n/S, and no other residue in the
+// block's sub-blocks is smaller.  So the block is zero if
+// permute[o >> 2] >= nonZeroInputs.  If the first sub-block is the only
+// non-zero one, the butterflies simply copy it to the other sub-blocks.
+//
+// A butterfly for rotation index k in a stage combining sub-blocks of size
+// halfLen contributes to the final outputs y with y % halfLen == k.
+// Since the needed outputs are a (cyclic) range, so are the needed k.
+
+void FFT::run(const Complex* f, Complex* out, int direction) const {
+  const unsigned int n = this->n;
+  const unsigned int m = nonZeroInputs;
+  if (n <= 2 && m < n) {
+    const Complex x = m > 0 ? f[0] : Complex(0, 0);
+    for (unsigned int i = 0; i < n; i++) {
+      out[i] = x;
+    }
+    return;
+  }
+  fallbackFFT(n, f, out);
+  double* const cosines = this->cosines;
+  unsigned int* const permute = this->permute;
+
+  const unsigned int nMask = n - 1;
+  const unsigned int quarterN = n >> 2;
+  const double negDirection = -direction;
+  const VComplex zero = vcomplex(0, 0);
+
+#define rotation(x) vcomplex(cosines[(x) & nMask], cosines[(quarterN - (x)) & nMask])
+
+  for (unsigned int out_offset = 0; out_offset < n; out_offset += 4) {
+    const unsigned int offset = permute[out_offset >> 2];
+    Complex* const o = out + out_offset;
+    if (offset >= m) {
+      vstore(o    , zero);
+      vstore(o + 1, zero);
+      vstore(o + 2, zero);
+      vstore(o + 3, zero);
+      continue;
+    }
+    const VComplex b0 = vload(f + offset);
+    if (offset + quarterN >= m) {
+      vstore(o    , b0);
+      vstore(o + 1, b0);
+      vstore(o + 2, b0);
+      vstore(o + 3, b0);
+      continue;
+    }
+    const VComplex b2 = vload(f + offset + quarterN);
+    const VComplex b1 = offset + 2 * quarterN < m ? vload(f + offset + 2 * quarterN) : zero;
+    const VComplex b3 = offset + 3 * quarterN < m ? vload(f + offset + 3 * quarterN) : zero;
+
+    const VComplex c0 =       b0 + b1;
+    const VComplex c1 =       b0 - b1;
+    const VComplex c2 =       b2 + b3;
+    const VComplex c3 = rot90(b2 - b3) * negDirection;
+
+    vstore(o    , c0 + c2);
+    vstore(o + 1, c1 + c3);
+    vstore(o + 2, c0 - c2);
+    vstore(o + 3, c1 - c3);
+  }
+
+#define BUTTERFLY(b0, b1, b2, b3) { \
+    const VComplex c0 =       b0 + b1; \
+    const VComplex c1 =       b0 - b1; \
+    const VComplex c2 =       b2 + b3; \
+    const VComplex c3 = rot90(b2 - b3) * negDirection; \
+    vstore(out + i0, c0 + c2); \
+    vstore(out + i1, c1 + c3); \
+    vstore(out + i2, c0 - c2); \
+    vstore(out + i3, c1 - c3); \
+  }
+
+  unsigned int len = 8;
+  int rStride = direction * (n >> 3);
+  for (; len < n; len <<= 2, rStride >>= 2) {
+    const unsigned int halfLen = len >> 1;
+    const unsigned int kMask = halfLen - 1;
+    const unsigned int kFirst = outStart & kMask;
+    const unsigned int nk = outCount < halfLen ? outCount : halfLen;
+    const int rStride1 = rStride >> 1;
+    const int rStride2 = rStride;
+    const int rStride3 = rStride2 + rStride1;
+    if (n / halfLen > m) {
+      // Some sub-blocks are zero.  So we look at each block separately.
+      const unsigned int residueMask = n / halfLen - 1;
+      for (unsigned int block = 0; block < n; block += len << 1) {
+        if (permute[block >> 2] >= m) {
+          continue;
+        }
+        const bool onlyFirst =
+          (permute[(block +     halfLen) >> 2] & residueMask) >= m &&
+          (permute[(block + 2 * halfLen) >> 2] & residueMask) >= m &&
+          (permute[(block + 3 * halfLen) >> 2] & residueMask) >= m;
+        for (unsigned int i = 0; i < nk; i++) {
+          const unsigned int k = (kFirst + i) & kMask;
+          const unsigned int i0 = block + k;
+          const unsigned int i1 = i0 + halfLen;
+          const unsigned int i2 = i1 + halfLen;
+          const unsigned int i3 = i2 + halfLen;
+          if (onlyFirst) {
+            const VComplex b0 = vload(out + i0);
+            vstore(out + i1, b0);
+            vstore(out + i2, b0);
+            vstore(out + i3, b0);
+          } else if (k == 0) {
+            const VComplex b0 = vload(out + i0);
+            const VComplex b1 = vload(out + i1);
+            const VComplex b2 = vload(out + i2);
+            const VComplex b3 = vload(out + i3);
+            BUTTERFLY(b0, b1, b2, b3)
+          } else {
+            const VComplex b0 = vload(out + i0);
+            const VComplex b1 = vload(out + i1) * rotation(-(int) k * rStride2);
+            const VComplex b2 = vload(out + i2) * rotation(-(int) k * rStride1);
+            const VComplex b3 = vload(out + i3) * rotation(-(int) k * rStride3);
+            BUTTERFLY(b0, b1, b2, b3)
+          }
+        }
+      }
+      continue;
+    }
+    for (unsigned int i = 0; i < nk; i++) {
+      const unsigned int k = (kFirst + i) & kMask;
+      if (k == 0) {
+        for (unsigned int i0 = 0; i0 < n; i0 += len << 1) {
+          const unsigned int i1 = i0 + halfLen;
+          const unsigned int i2 = i1 + halfLen;
+          const unsigned int i3 = i2 + halfLen;
+
+          const VComplex b0 = vload(out + i0);
+          const VComplex b1 = vload(out + i1);
+          const VComplex b2 = vload(out + i2);
+          const VComplex b3 = vload(out + i3);
+          BUTTERFLY(b0, b1, b2, b3)
+        }
+        continue;
+      }
+      const VComplex r1 = rotation(-(int) k * rStride1);
+      const VComplex r2 = rotation(-(int) k * rStride2);
+      const VComplex r3 = rotation(-(int) k * rStride3);
+      for (unsigned int i0 = k; i0 < n; i0 += len << 1) {
+        const unsigned int i1 = i0 + halfLen;
+        const unsigned int i2 = i1 + halfLen;
+        const unsigned int i3 = i2 + halfLen;
+
+        const VComplex b0 = vload(out + i0);
+        const VComplex b1 = vload(out + i1) * r2;
+        const VComplex b2 = vload(out + i2) * r1;
+        const VComplex b3 = vload(out + i3) * r3;
+        BUTTERFLY(b0, b1, b2, b3)
+      }
+    }
+  }
+
+#undef BUTTERFLY
+
+  if (len == n) {
+    // If we come here, n is not a power of 4 (but still a power of 2).
+    // So we need to run one extra round of 2-way butterflies.
+    const unsigned int halfLen = len >> 1;
+    const unsigned int kMask = halfLen - 1;
+    const unsigned int kFirst = outStart & kMask;
+    const unsigned int nk = outCount < halfLen ? outCount : halfLen;
+    // The second half is the DFT of the odd inputs.
+    const bool onlyFirst = m < 2;
+    for (unsigned int i = 0; i < nk; i++) {
+      const unsigned int k0 = (kFirst + i) & kMask;
+      const unsigned int k1 = k0 + halfLen;
+
+      const VComplex z0 = vload(out + k0);
+      if (onlyFirst) {
+        vstore(out + k1, z0);
+        continue;
+      }
+      const VComplex z1 = k0 == 0
+        ? vload(out + k1)
+        : vload(out + k1) * rotation(-(int) k0 * rStride);
+
+      vstore(out + k0, z0 + z1);
+      vstore(out + k1, z0 - z1);
+    }
+  }
+
+#undef rotation
+
+}
+
+FFT_C_API_BEGIN
+  FFT* prepare_fft_pruned(
+    unsigned int n, unsigned int nonZeroInputs, unsigned int outStart, unsigned int outCount
+  ) {
+    return new FFT(n, nonZeroInputs, outStart, outCount);
+  }
+FFT_C_API_END
+
+#include "c_bindings.c++"
@@ -0,0 +1,40 @@
+#ifndef FFT47PRUNED_HPP
+#define FFT47PRUNED_HPP 1
+
+#include "complex.h++"
+#include "c_bindings.h++"
+
+// fft47 with pruning for inputs with many zeros at the end
+// (such as zero-padded signals) and/or for a narrow band of needed outputs.
+//
+// - Only `f[0 .. nonZeroInputs)` are read.  The remaining inputs are treated
+//   as zero.  Butterflies whose inputs are all zero are skipped and
+//   butterflies with a single non-zero input become copies.
+// - Only the outputs `out[(outStart + i) % n]` for `0 <= i < outCount` are
+//   computed.  Butterflies contributing only to other outputs are skipped,
+//   so the remaining elements of `out` are unspecified.
+//
+// `prepare_fft(n)` creates an unpruned plan.
+class FFT {
+  unsigned int n;
+  double* cosines;
+  unsigned int* permute;
+  unsigned int nonZeroInputs;
+  unsigned int outStart;
+  unsigned int outCount;
+
+public:
+  FFT(unsigned int n, unsigned int nonZeroInputs, unsigned int outStart, unsigned int outCount);
+  FFT(unsigned int n) : FFT(n, n, 0, n) {}
+  ~FFT();
+
+  void run(const Complex* f, Complex* out, int direction = 1) const;
+};
+
+FFT_C_API_BEGIN
+  FFT* prepare_fft_pruned(
+    unsigned int n, unsigned int nonZeroInputs, unsigned int outStart, unsigned int outCount
+  );
+FFT_C_API_END
+
+#endif
@@ -1,33 +1,18 @@
 #include "fft48.h++"
 #include "complex.h++"
+#include "cobra.h++"
 #include "fallbackFFT.h++"
+#include "tables.h++"
 #include <math.h>
 
-const double TAU = 6.2831853071795864769;
-
 FFT::FFT(unsigned int n) {
   double* cosines = new double[n];
-  for (unsigned int i = 0; i < n; i++) {
-    cosines[i] = cos(TAU * i / n);
-  }
+  fillCosines(cosines, n, n);
 
+  // the first quarter of the bit-reversal permutation of n indices
   const unsigned int quarterN = n >> 2;
   unsigned int* permute = new unsigned int[quarterN];
-  for (unsigned int i = 0; i < quarterN; i++) {
-    permute[i] = 0;
-  }
-  for (unsigned int len = n, fStride = 1; len > 1; len >>= 1, fStride <<= 1) {
-    unsigned int halfLen = len >> 1;
-    for (unsigned int out_offset = 0; out_offset < n; out_offset += len) {
-      unsigned int limit = out_offset + len;
-      for (unsigned int out_offset_odd = out_offset + halfLen; out_offset_odd < limit; out_offset_odd++) {
-        // TODO tweak the loops to make this test superfluous
-        if (out_offset_odd < quarterN) {
-          permute[out_offset_odd] += fStride;
-        }
-      }
-    }
-  }
+  fillBitReversal(permute, quarterN, n);
 
   this->n = n;
   this->cosines = cosines;
@@ -35,8 +20,8 @@ FFT::FFT(unsigned int n) {
 }
 
 FFT::~FFT() {
-  delete cosines;
-  delete permute;
+  delete[] cosines;
+  delete[] permute;
 }
 
 void FFT::run(const Complex* f, Complex* out, int direction) const {
@@ -51,14 +36,9 @@ void FFT::run(const Complex* f, Complex* out, int direction) const {
 
 #define rotation(x) Complex(cosines[(x) & nMask], cosines[(quarterN - (x)) & nMask])
 
-  for (unsigned int out_offset = 0; out_offset < n;) {
-    // Notice that permute[out_offset] == permute[out_offset >> 2] >> 2.
-    unsigned int offset = permute[out_offset >> 2] >> 2;
-    const Complex b0 = f[offset]; offset += quarterN;
-    const Complex b2 = f[offset]; offset += quarterN;
-    const Complex b1 = f[offset]; offset += quarterN;
-    const Complex b3 = f[offset];
-
+  // b0, ..., b3 are the inputs for the outputs out_offset, ..., out_offset + 3
+  // in bit-reversed order.
+  auto butterfly = [&](unsigned int out_offset, Complex b0, Complex b1, Complex b2, Complex b3) {
     const Complex c0 =       b0 + b1;
     const Complex c1 =       b0 - b1;
     const Complex c2 =       b2 + b3;
@@ -68,6 +48,22 @@ void FFT::run(const Complex* f, Complex* out, int direction) const {
     out[out_offset++] = c1 + c3;
     out[out_offset++] = c0 - c2;
     out[out_offset++] = c1 - c3;
+  };
+
+  if (n >= cobraMinN) {
+    bitReversedGroups(f, n, 4, [&](unsigned int out_offset, const Complex* x) {
+      butterfly(out_offset, x[0], x[1], x[2], x[3]);
+    });
+  } else {
+    for (unsigned int out_offset = 0; out_offset < n; out_offset += 4) {
+      // Notice that permute[out_offset] == permute[out_offset >> 2] >> 2.
+      unsigned int offset = permute[out_offset >> 2] >> 2;
+      const Complex b0 = f[offset]; offset += quarterN;
+      const Complex b2 = f[offset]; offset += quarterN;
+      const Complex b1 = f[offset]; offset += quarterN;
+      const Complex b3 = f[offset];
+      butterfly(out_offset, b0, b1, b2, b3);
+    }
   }
 
   unsigned int len = 8;
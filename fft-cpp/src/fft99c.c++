@@ -1,10 +1,13 @@
 #include "fft99c.h++"
+#include "buffers.h++"
 #include "complex.h++"
-#include "fallbackFFT.h++"
+#include "c_bindings.h++"
+#include "cobra.h++"
+#include "postprocess.h++"
+#include "simd128.h++"
+#include "tables.h++"
 #include <math.h>
 
-const double TAU = 6.2831853071795864769;
-
 const unsigned int c31 = 8 * sizeof(int) - 1;
 
 FFT::FFT(unsigned int n) {
@@ -12,99 +15,253 @@ FFT::FFT(unsigned int n) {
   unsigned int quarterN = n >> 2;
 
   double* cosines = new double[quarterN + 1];
-  for (unsigned int i = 0; i <= quarterN; i++) {
-    cosines[i] = cos(TAU * i / n);
-  }
+  fillCosines(cosines, n, quarterN + 1);
 
   unsigned int* permute = new unsigned int[halfN];
-  for (unsigned int i = 0; i < halfN; i++) {
-    permute[i] = 0;
-  }
-  for (unsigned int len = halfN, fStride = 1; len > 1; len >>= 1, fStride <<= 1) {
-    unsigned int halfLen = len >> 1;
-    for (unsigned int out_offset = 0; out_offset < halfN; out_offset += len) {
-      unsigned int limit = out_offset + len;
-      for (unsigned int out_offset_odd = out_offset + halfLen; out_offset_odd < limit; out_offset_odd++) {
-        permute[out_offset_odd] += fStride;
-      }
-    }
-  }
+  fillBitReversal(permute, halfN, halfN);
 
   this->n = n;
   this->cosines = cosines;
   this->permute = permute;
+  this->outputMode = FFT_OUTPUT_COMPLEX;
+  this->forwardScale = 1;
+  this->inverseScale = 1;
+  this->scratch = 0;
+  this->image = 0;
 }
 
 FFT::~FFT() {
-  delete cosines;
-  delete permute;
+  if (image) {
+    unmapPlanImage(image);
+    delete image;
+  } else {
+    delete[] cosines;
+    delete[] permute;
+  }
+  delete[] scratch;
 }
 
-void FFT::run(const Complex* f, Complex* out, int direction) const {
+// See tables.h++.
+static const char planEngine[] = "fft99c";
+
+FFT::FFT(PlanImage* image) {
+  // The tables are mapped read-only, but run() does not write them anyway.
+  this->n = image->n;
+  this->cosines = (double*) image->cosines;
+  this->permute = (unsigned int*) image->permute;
+  this->outputMode = FFT_OUTPUT_COMPLEX;
+  this->forwardScale = 1;
+  this->inverseScale = 1;
+  this->scratch = 0;
+  this->image = image;
+}
+
+FFT* FFT::load(const char* path) {
+  PlanImage* image = new PlanImage;
+  if (mapPlanImage(path, planEngine, image) != 0) {
+    delete image;
+    return 0;
+  }
+  const unsigned int n = image->n;
+  if (image->nCosines != (n >> 2) + 1 || image->nPermute != n >> 1) {
+    unmapPlanImage(image);
+    delete image;
+    return 0;
+  }
+  return new FFT(image);
+}
+
+int FFT::save(const char* path) const {
+  return writePlanImage(path, planEngine, n, cosines, (n >> 2) + 1, permute, n >> 1);
+}
+
+// Post-processing (see postprocess.h++) is fused into the last stage:
+// All stages but the last one store their results with a `WorkStore`,
+// the last one with the output selected by `run`.
+struct WorkStore {
+  Complex* work;
+  inline void operator()(unsigned int i, VComplex z) const {
+    vstore(work + i, z);
+  }
+};
+
+template <class Store>
+void FFT::stage(Complex* work, unsigned int halfLen, unsigned int rStride, int direction, Store store) const {
+  const unsigned int n = this->n;
+  const double* const cosines = this->cosines;
+  const unsigned int quarterN = n >> 2;
+  const double negDirection = -direction;
+
+  const unsigned int quarterLen = halfLen >> 1;
+  for (unsigned int out_offset = 0; out_offset < n;) {
+    const unsigned int i0 = out_offset; out_offset += quarterLen;
+    const unsigned int i1 = out_offset; out_offset += quarterLen;
+    const unsigned int i2 = out_offset; out_offset += quarterLen;
+    const unsigned int i3 = out_offset; out_offset += quarterLen;
+
+    const VComplex z0 = vload(work + i0);
+    const VComplex z1 = vload(work + i1);
+    const VComplex z2 = vload(work + i2);
+    const VComplex z3 = rot90(vload(work + i3)) * negDirection;
+
+    store(i0, z0 + z2);
+    store(i1, z1 + z3);
+    store(i2, z0 - z2);
+    store(i3, z1 - z3);
+  }
+  int rOffset = quarterN;
+  unsigned int k = 0;
+  for (unsigned int limit = quarterLen; limit <= halfLen; limit += quarterLen) {
+    k++; rOffset -= rStride; // skip the two cases simplified above
+    for (; k < limit; k++) {
+      int rSign = (rOffset >> c31) * 2 + 1;
+      unsigned int rAbs = rSign * rOffset;
+      const VComplex r = vcomplex(
+        rSign * cosines[quarterN - rAbs],
+        -direction * cosines[rAbs]
+      );
+      rOffset -= rStride;
+
+      for (unsigned int out_offset = k; out_offset < n;) {
+        const unsigned int i0 = out_offset; out_offset += halfLen;
+        const unsigned int i1 = out_offset; out_offset += halfLen;
+
+        const VComplex z0 = vload(work + i0);
+        const VComplex z1 = vload(work + i1) * r;
+
+        store(i0, z0 + z1);
+        store(i1, z0 - z1);
+      }
+    }
+  }
+}
+
+template <class Output>
+void FFT::runWith(const Complex* f, Complex* work, int direction, Output output) const {
   unsigned int n = this->n;
-  fallbackFFT(n, f, out);
-  double* cosines = this->cosines;
+  switch (n) {
+    case 1: {
+      output(0, vload(f));
+      return;
+    }
+    case 2: {
+      const VComplex z0 = vload(f);
+      const VComplex z1 = vload(f + 1);
+      output(0, z0 + z1);
+      output(1, z0 - z1);
+      return;
+    }
+  }
   unsigned int* permute = this->permute;
 
   unsigned int halfN = n >> 1;
   unsigned int quarterN = n >> 2;
 
-  for (unsigned int out_offset = 0; out_offset < n;) {
-    const unsigned int i0 = permute[out_offset >> 1];
-    const unsigned int i1 = i0 + halfN;
+  if (n >= cobraMinN) {
+    const CobraStore toWorkFirst{work};
+    bitReversedGroups(f, n, 2, [&](unsigned int out_offset, const Complex* x) {
+      const VComplex z0 = vload(x);
+      const VComplex z1 = vload(x + 1);
+
+      toWorkFirst(out_offset++, z0 + z1);
+      toWorkFirst(out_offset++, z0 - z1);
+    });
+    toWorkFirst.finish();
+  } else {
+    for (unsigned int out_offset = 0; out_offset < n;) {
+      const unsigned int i0 = permute[out_offset >> 1];
+      const unsigned int i1 = i0 + halfN;
 
-    const Complex z0 = f[i0];
-    const Complex z1 = f[i1];
+      const VComplex z0 = vload(f + i0);
+      const VComplex z1 = vload(f + i1);
 
-    out[out_offset++] = z0 + z1;
-    out[out_offset++] = z0 - z1;
+      vstore(work + out_offset++, z0 + z1);
+      vstore(work + out_offset++, z0 - z1);
+    }
   }
 
+  const WorkStore toWork{work};
   for (unsigned int halfLen = 2, rStride = quarterN; rStride; halfLen <<= 1, rStride >>= 1) {
-    const unsigned int quarterLen = halfLen >> 1;
-    for (unsigned int out_offset = 0; out_offset < n;) {
-      const unsigned int i0 = out_offset; out_offset += quarterLen;
-      const unsigned int i1 = out_offset; out_offset += quarterLen;
-      const unsigned int i2 = out_offset; out_offset += quarterLen;
-      const unsigned int i3 = out_offset; out_offset += quarterLen;
-
-      const Complex z0  = out[i0];
-      const Complex z1  = out[i1];
-      const Complex z2  = out[i2];
-      const Complex aux = out[i3];
-      const Complex z3  = Complex(direction * aux.imag(), -direction * aux.real());
-
-      out[i0] = z0 + z2;
-      out[i1] = z1 + z3;
-      out[i2] = z0 - z2;
-      out[i3] = z1 - z3;
-    }
-    int rOffset = quarterN;
-    unsigned int k = 0;
-    for (unsigned int limit = quarterLen; limit <= halfLen; limit += quarterLen) {
-      k++; rOffset -= rStride; // skip the two cases simplified above
-      for (; k < limit; k++) {
-        int rSign = (rOffset >> c31) * 2 + 1;
-        unsigned int rAbs = rSign * rOffset;
-        Complex r(
-          rSign * cosines[quarterN - rAbs],
-          -direction * cosines[rAbs]
-        );
-        rOffset -= rStride;
-
-        for (unsigned int out_offset = k; out_offset < n;) {
-          const unsigned int i0 = out_offset; out_offset += halfLen;
-          const unsigned int i1 = out_offset; out_offset += halfLen;
-
-          const Complex z0 = out[i0];
-          const Complex z1 = out[i1] * r;
-
-          out[i0] = z0 + z1;
-          out[i1] = z0 - z1;
-        }
-      }
+    if (rStride == 1) {
+      stage(work, halfLen, rStride, direction, output);
+    } else {
+      stage(work, halfLen, rStride, direction, toWork);
     }
   }
 }
 
+void FFT::run(const Complex* f, Complex* out, int direction) const {
+  run(f, out, direction, scratch);
+}
+
+void FFT::run(const Complex* f, Complex* out, int direction, Complex* scratch) const {
+  const double scale = direction > 0 ? forwardScale : inverseScale;
+  // The real-valued modes write to `out` what they have read from `scratch`.
+  // So they also work in place.
+  Complex* const work = outputMode == FFT_OUTPUT_COMPLEX ? out : scratch;
+  withOutput(outputMode, scale, out, [&](auto output) {
+    runWith(f, work, direction, output);
+  });
+}
+
+int FFT::setOutput(int mode, double forwardScale, double inverseScale) {
+  if (mode < FFT_OUTPUT_COMPLEX || mode > FFT_OUTPUT_LOG_POWER) {
+    return -1;
+  }
+  if (mode != FFT_OUTPUT_COMPLEX && !scratch) {
+    scratch = new Complex[n];
+  }
+  this->outputMode = mode;
+  this->forwardScale = forwardScale;
+  this->inverseScale = inverseScale;
+  return 0;
+}
+
+PlanBuffers& FFT::getBuffers() {
+  buffers.allocate(n);
+  return buffers;
+}
+
+bool FFT::setInputs(const double* re, const double* im) {
+  return buffers.setInputs(n, re, im);
+}
+
+bool FFT::getOutputs(double* re, double* im) {
+  return buffers.getOutputs(n, outputMode != FFT_OUTPUT_COMPLEX, re, im);
+}
+
+FFT_C_API_BEGIN
+  int set_fft_output(FFT* fft, int mode, double forwardScale, double inverseScale) {
+    return fft->setOutput(mode, forwardScale, inverseScale);
+  }
+
+  void run_fft_with_work(FFT* fft, const Complex* input, Complex* output, int direction, Complex* work) {
+    fft->run(input, output, direction, work);
+  }
+
+  int save_fft_plan(const FFT* fft, const char* path) {
+    return fft->save(path);
+  }
+
+  FFT* load_fft_plan(const char* path) {
+    return FFT::load(path);
+  }
+
+  Complex* fft_input_buffer(FFT* fft) {
+    return fft->getBuffers().input;
+  }
+
+  Complex* fft_output_buffer(FFT* fft) {
+    return fft->getBuffers().output;
+  }
+
+  int fft_set_inputs(FFT* fft, const double* re, const double* im) {
+    return fft->setInputs(re, im) ? 0 : -1;
+  }
+
+  int fft_get_outputs(FFT* fft, double* re, double* im) {
+    return fft->getOutputs(re, im) ? 0 : -1;
+  }
+FFT_C_API_END
+
 #include "c_bindings.c++"
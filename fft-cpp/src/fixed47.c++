@@ -0,0 +1,255 @@
+#include "fixed47.h++"
+#include "tables.h++"
+#include <math.h>
+
+// Intermediate results are computed with twice the width of the samples.
+template <class T> struct FixedTraits;
+template <> struct FixedTraits<int16_t> {
+  typedef int32_t Wide;
+  static const int fractionBits = 15;
+};
+template <> struct FixedTraits<int32_t> {
+  typedef int64_t Wide;
+  static const int fractionBits = 31;
+};
+
+template <class W>
+struct WideComplex {
+  W re, im;
+};
+
+template <class W>
+inline WideComplex<W> operator+(const WideComplex<W>& x, const WideComplex<W>& y) {
+  return WideComplex<W>{x.re + y.re, x.im + y.im};
+}
+
+template <class W>
+inline WideComplex<W> operator-(const WideComplex<W>& x, const WideComplex<W>& y) {
+  return WideComplex<W>{x.re - y.re, x.im - y.im};
+}
+
+// rot90(z) * -direction, as in the floating-point versions
+template <class W>
+inline WideComplex<W> rot90neg(const WideComplex<W>& z, int direction) {
+  return WideComplex<W>{direction * z.im, -direction * z.re};
+}
+
+template <class T>
+inline WideComplex<typename FixedTraits<T>::Wide> widen(const FixedComplex<T>& z) {
+  typedef typename FixedTraits<T>::Wide W;
+  return WideComplex<W>{(W) z.re, (W) z.im};
+}
+
+// Fixed-point multiplication with rounding.  The result is not yet narrowed
+// so that it can be added to other values without overflow.
+template <class T>
+inline WideComplex<typename FixedTraits<T>::Wide> mul(const FixedComplex<T>& x, const FixedComplex<T>& y) {
+  typedef typename FixedTraits<T>::Wide W;
+  const int bits = FixedTraits<T>::fractionBits;
+  const W half = (W) 1 << (bits - 1);
+  const W x_re = x.re, x_im = x.im;
+  const W y_re = y.re, y_im = y.im;
+  return WideComplex<W>{
+    (x_re * y_re - x_im * y_im + half) >> bits,
+    (x_re * y_im + x_im * y_re + half) >> bits,
+  };
+}
+
+// Scale down by 2^shift (with rounding) and narrow to the sample type.
+template <class T, int shift>
+inline FixedComplex<T> narrow(const WideComplex<typename FixedTraits<T>::Wide>& z) {
+  typedef typename FixedTraits<T>::Wide W;
+  const W half = (W) 1 << (shift - 1);
+  return FixedComplex<T>{(T) ((z.re + half) >> shift), (T) ((z.im + half) >> shift)};
+}
+
+template <class T>
+FixedFFT<T>::FixedFFT(unsigned int n) {
+  typedef typename FixedTraits<T>::Wide W;
+  // Like kissfft we use the largest representable value (not 1.0) for the
+  // cosine of 0° so that rotations never increase magnitudes.
+  const double one = (double) (((W) 1 << FixedTraits<T>::fractionBits) - 1);
+  double* exact = new double[n];
+  fillCosines(exact, n, n);
+  T* cosines = new T[n];
+  for (unsigned int i = 0; i < n; i++) {
+    cosines[i] = (T) floor(0.5 + one * exact[i]);
+  }
+  delete[] exact;
+
+  const unsigned int quarterN = n >> 2;
+  unsigned int* permute = new unsigned int[quarterN];
+  fillBitReversal(permute, quarterN, quarterN);
+
+  this->n = n;
+  this->cosines = cosines;
+  this->permute = permute;
+}
+
+template <class T>
+FixedFFT<T>::~FixedFFT() {
+  delete[] cosines;
+  delete[] permute;
+}
+
+template <class T>
+void FixedFFT<T>::run(const FixedComplex<T>* f, FixedComplex<T>* out, int direction) const {
+  typedef FixedComplex<T> C;
+  typedef WideComplex<typename FixedTraits<T>::Wide> WC;
+
+  const unsigned int n = this->n;
+  switch (n) {
+    case 1: {
+      out[0] = f[0];
+      return;
+    }
+    case 2: {
+      const WC z0 = widen(f[0]);
+      const WC z1 = widen(f[1]);
+      out[0] = narrow<T, 1>(z0 + z1);
+      out[1] = narrow<T, 1>(z0 - z1);
+      return;
+    }
+  }
+  const T* const cosines = this->cosines;
+  const unsigned int* const permute = this->permute;
+
+  const unsigned int nMask = n - 1;
+  const unsigned int quarterN = n >> 2;
+
+#define rotation(x) C{cosines[(x) & nMask], cosines[(quarterN - (x)) & nMask]}
+
+  for (unsigned int out_offset = 0; out_offset < n;) {
+    unsigned int offset = permute[out_offset >> 2];
+    const WC b0 = widen(f[offset]); offset += quarterN;
+    const WC b2 = widen(f[offset]); offset += quarterN;
+    const WC b1 = widen(f[offset]); offset += quarterN;
+    const WC b3 = widen(f[offset]);
+
+    const WC c0 = b0 + b1;
+    const WC c1 = b0 - b1;
+    const WC c2 = b2 + b3;
+    const WC c3 = rot90neg(b2 - b3, direction);
+
+    out[out_offset++] = narrow<T, 2>(c0 + c2);
+    out[out_offset++] = narrow<T, 2>(c1 + c3);
+    out[out_offset++] = narrow<T, 2>(c0 - c2);
+    out[out_offset++] = narrow<T, 2>(c1 - c3);
+  }
+
+  unsigned int len = 8;
+  int rStride = direction * (n >> 3);
+  for (; len < n; len <<= 2, rStride >>= 2) {
+    const unsigned int halfLen = len >> 1;
+    {
+      for (unsigned int out_offset = 0; out_offset < n;) {
+        unsigned int i0 = out_offset; out_offset += halfLen;
+        unsigned int i1 = out_offset; out_offset += halfLen;
+        unsigned int i2 = out_offset; out_offset += halfLen;
+        unsigned int i3 = out_offset; out_offset += halfLen;
+
+        const WC b0 = widen(out[i0]);
+        const WC b1 = widen(out[i1]);
+        const WC b2 = widen(out[i2]);
+        const WC b3 = widen(out[i3]);
+
+        const WC c0 = b0 + b1;
+        const WC c1 = b0 - b1;
+        const WC c2 = b2 + b3;
+        const WC c3 = rot90neg(b2 - b3, direction);
+
+        out[i0] = narrow<T, 2>(c0 + c2);
+        out[i1] = narrow<T, 2>(c1 + c3);
+        out[i2] = narrow<T, 2>(c0 - c2);
+        out[i3] = narrow<T, 2>(c1 - c3);
+      }
+    }
+    const int rStride1 = rStride >> 1;
+    const int rStride2 = rStride;
+    const int rStride3 = rStride2 + rStride1;
+    int rOffset1 = -rStride1;
+    int rOffset2 = -rStride2;
+    int rOffset3 = -rStride3;
+    for (unsigned int k = 1; k < halfLen; k++) {
+      const C r1 = rotation(rOffset1); rOffset1 -= rStride1;
+      const C r2 = rotation(rOffset2); rOffset2 -= rStride2;
+      const C r3 = rotation(rOffset3); rOffset3 -= rStride3;
+      for (unsigned int out_offset = k; out_offset < n;) {
+        unsigned int i0 = out_offset; out_offset += halfLen;
+        unsigned int i1 = out_offset; out_offset += halfLen;
+        unsigned int i2 = out_offset; out_offset += halfLen;
+        unsigned int i3 = out_offset; out_offset += halfLen;
+
+        const WC b0 = widen(out[i0]);
+        const WC b1 = mul(out[i1], r2);
+        const WC b2 = mul(out[i2], r1);
+        const WC b3 = mul(out[i3], r3);
+
+        const WC c0 = b0 + b1;
+        const WC c1 = b0 - b1;
+        const WC c2 = b2 + b3;
+        const WC c3 = rot90neg(b2 - b3, direction);
+
+        out[i0] = narrow<T, 2>(c0 + c2);
+        out[i1] = narrow<T, 2>(c1 + c3);
+        out[i2] = narrow<T, 2>(c0 - c2);
+        out[i3] = narrow<T, 2>(c1 - c3);
+      }
+    }
+  }
+  if (len == n) {
+    // If we come here, n is not a power of 4 (but still a power of 2).
+    // So we need to run one extra round of 2-way butterflies.
+    const unsigned int halfLen = len >> 1;
+
+    {
+      const WC z0 = widen(out[0      ]);
+      const WC z1 = widen(out[halfLen]);
+
+      out[0      ] = narrow<T, 1>(z0 + z1);
+      out[halfLen] = narrow<T, 1>(z0 - z1);
+    }
+    int rOffset = -rStride;
+    for (unsigned int k0 = 1, k1 = halfLen + 1; k0 < halfLen; k0++, k1++) {
+      const C r = rotation(rOffset); rOffset -= rStride;
+
+      const WC z0 = widen(out[k0]);
+      const WC z1 = mul(out[k1], r);
+
+      out[k0] = narrow<T, 1>(z0 + z1);
+      out[k1] = narrow<T, 1>(z0 - z1);
+    }
+  }
+
+#undef rotation
+
+}
+
+template class FixedFFT<int16_t>;
+template class FixedFFT<int32_t>;
+
+extern "C" {
+  FixedFFTQ15* prepare_fft_q15(unsigned int n) {
+    return new FixedFFTQ15(n);
+  }
+
+  void run_fft_q15(FixedFFTQ15* fft, const ComplexQ15* input, ComplexQ15* output, int direction) {
+    fft->run(input, output, direction);
+  }
+
+  void delete_fft_q15(FixedFFTQ15* fft) {
+    delete fft;
+  }
+
+  FixedFFTQ31* prepare_fft_q31(unsigned int n) {
+    return new FixedFFTQ31(n);
+  }
+
+  void run_fft_q31(FixedFFTQ31* fft, const ComplexQ31* input, ComplexQ31* output, int direction) {
+    fft->run(input, output, direction);
+  }
+
+  void delete_fft_q31(FixedFFTQ31* fft) {
+    delete fft;
+  }
+}
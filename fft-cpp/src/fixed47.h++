@@ -0,0 +1,50 @@
+#ifndef FIXED47_HPP
+#define FIXED47_HPP 1
+
+#include <stdint.h>
+
+// Complex numbers with fixed-point components.
+// 16-bit components are interpreted as Q15 numbers and 32-bit components
+// as Q31 numbers, that is, as multiples of 2^-15 or 2^-31, respectively,
+// in the range [-1, 1).
+template <class T>
+struct FixedComplex {
+  T re, im;
+};
+
+typedef FixedComplex<int16_t> ComplexQ15;
+typedef FixedComplex<int32_t> ComplexQ31;
+
+// A fixed-point variant of fft47.
+//
+// Every radix-4 stage divides its results by 4 and the final radix-2 stage
+// (if needed) by 2.  So the output is the DFT of the input divided by n
+// (in both directions).  As long as the input values have magnitudes
+// (not just components) below 1 no intermediate result overflows.
+template <class T>
+class FixedFFT {
+  unsigned int n;
+  T* cosines;
+  unsigned int* permute;
+
+public:
+  FixedFFT(unsigned int n);
+  ~FixedFFT();
+
+  void run(const FixedComplex<T>* f, FixedComplex<T>* out, int direction = 1) const;
+};
+
+typedef FixedFFT<int16_t> FixedFFTQ15;
+typedef FixedFFT<int32_t> FixedFFTQ31;
+
+extern "C" {
+  FixedFFTQ15* prepare_fft_q15(unsigned int n);
+  void run_fft_q15(FixedFFTQ15* fft, const ComplexQ15* input, ComplexQ15* output, int direction = 1);
+  void delete_fft_q15(FixedFFTQ15* fft);
+
+  FixedFFTQ31* prepare_fft_q31(unsigned int n);
+  void run_fft_q31(FixedFFTQ31* fft, const ComplexQ31* input, ComplexQ31* output, int direction = 1);
+  void delete_fft_q31(FixedFFTQ31* fft);
+}
+
+#endif
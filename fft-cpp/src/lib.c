@@ -1,52 +1,329 @@
-// These simplistic implementations suffice for now
-// as these functions are not called in performance-critical code.
-// Otherwise we might use something like
-// - memset() from https://embeddedartistry.com/blog/2017/03/22/memset-memcpy-memcmp-and-memmove/
-// - memcpy() from https://opensource.apple.com/source/xnu/xnu-2050.7.9/libsyscall/wrappers/memcpy.c
-// Or call the linker in such a way that it takes these functions
-// from the std lib but still leaving cos and sin unresolved
+// Minimal runtime support for the `-nostdlib` WebAssembly builds
+// (and the memory functions also for the Emscripten builds).
+//
+// Alternatively we could call the linker in such a way that it takes these
+// functions from the std lib but still leaves cos and sin unresolved.
 
 typedef unsigned long size_t;
 
 typedef unsigned char* byte_ptr_t;
 
+// ---------------------------------------------------------------------------
+// memset, memcpy, memmove
+//
+// With `-mbulk-memory` the builtins compile to the `memory.fill` and
+// `memory.copy` instructions.  Otherwise we copy 8 bytes at a time where
+// the alignment permits this.
+// (`no_builtin` keeps the compiler from replacing our loops by calls to
+// the very functions we are defining.)
+
+#ifdef __wasm_bulk_memory__
+
+void* memset(void* dst, int val, size_t n) {
+  return __builtin_memset(dst, val, n);
+}
+
+void* memcpy(void* dst, const void* src, size_t n) {
+  return __builtin_memcpy(dst, src, n);
+}
+
+void* memmove(void* dst, const void* src, size_t n) {
+  return __builtin_memmove(dst, src, n);
+}
+
+#else
+
+typedef unsigned long long __attribute__((__may_alias__)) word_t;
+#define WORD_MASK (sizeof(word_t) - 1)
+
+__attribute__((no_builtin))
 void* memset(void* dst, int val, size_t n) {
   byte_ptr_t dst_ = (byte_ptr_t) dst;
-  for (size_t i = 0; i < n; i++) {
-    dst_[i] = val;
+  for (; n > 0 && ((size_t) dst_ & WORD_MASK); n--) {
+    *dst_++ = val;
+  }
+  const word_t pattern = (unsigned char) val * 0x0101010101010101ULL;
+  for (; n >= sizeof(word_t); n -= sizeof(word_t), dst_ += sizeof(word_t)) {
+    *(word_t*) dst_ = pattern;
+  }
+  for (; n > 0; n--) {
+    *dst_++ = val;
   }
   return dst;
 }
 
-void* memcpy(void* dst, const void* src, size_t n) {
-  byte_ptr_t dst_ = (byte_ptr_t) dst;
-  byte_ptr_t src_ = (byte_ptr_t) src;
-  for (size_t i = 0; i < n; i++) {
-    dst_[i] = src_[i];
+// Copy upwards.  This is also ok for overlapping regions with dst < src.
+__attribute__((no_builtin))
+static void copyForward(byte_ptr_t dst_, byte_ptr_t src_, size_t n) {
+  if ((((size_t) dst_ ^ (size_t) src_) & WORD_MASK) == 0) {
+    for (; n > 0 && ((size_t) dst_ & WORD_MASK); n--) {
+      *dst_++ = *src_++;
+    }
+    for (; n >= sizeof(word_t); n -= sizeof(word_t), dst_ += sizeof(word_t), src_ += sizeof(word_t)) {
+      *(word_t*) dst_ = *(word_t*) src_;
+    }
+  }
+  for (; n > 0; n--) {
+    *dst_++ = *src_++;
   }
+}
+
+// Copy downwards.  This is also ok for overlapping regions with dst > src.
+__attribute__((no_builtin))
+static void copyBackward(byte_ptr_t dst_, byte_ptr_t src_, size_t n) {
+  dst_ += n;
+  src_ += n;
+  if ((((size_t) dst_ ^ (size_t) src_) & WORD_MASK) == 0) {
+    for (; n > 0 && ((size_t) dst_ & WORD_MASK); n--) {
+      *--dst_ = *--src_;
+    }
+    for (; n >= sizeof(word_t); n -= sizeof(word_t)) {
+      dst_ -= sizeof(word_t);
+      src_ -= sizeof(word_t);
+      *(word_t*) dst_ = *(word_t*) src_;
+    }
+  }
+  for (; n > 0; n--) {
+    *--dst_ = *--src_;
+  }
+}
+
+void* memcpy(void* dst, const void* src, size_t n) {
+  copyForward((byte_ptr_t) dst, (byte_ptr_t) src, n);
   return dst;
 }
 
 void* memmove(void* dst, const void* src, size_t n) {
   byte_ptr_t dst_ = (byte_ptr_t) dst;
   byte_ptr_t src_ = (byte_ptr_t) src;
+  if (dst_ > src_ && dst_ < src_ + n) {
+    copyBackward(dst_, src_, n);
+  } else if (dst_ != src_) {
+    copyForward(dst_, src_, n);
+  }
+  return dst;
+}
+
+#undef WORD_MASK
+
+#endif
+
+// ---------------------------------------------------------------------------
+// malloc, free, operator new/delete
+//
+// Emscripten brings its own malloc.
+// With EXTERNAL_HEAP the heap is managed from JS (`ts/makeHeap.ts`).
+// This is needed for the builds linked with `-shared` (fft01, fft02),
+// where `__heap_base` is not available.
+
+#if !defined(__EMSCRIPTEN__) && !defined(EXTERNAL_HEAP)
+
+// Every block starts with a 16-byte header, so the returned addresses are
+// 16-byte aligned.
+//
+// Small blocks (up to SMALL_MAX bytes including the header) have
+// power-of-2 sizes.  Freed small blocks go to a free list for their size
+// class and are reused by later allocations of the same class.
+//
+// Large blocks are sized exactly (in multiples of 16 bytes), so that the
+// header does not double the power-of-2 arrays of the transforms.  Freed
+// large blocks are kept in a list sorted by address, where neighbors are
+// merged.  An allocation takes the best fitting free block and splits off
+// the rest if that is large enough.
+//
+// New blocks are cut from an arena starting at `__heap_base`, growing the
+// memory as needed.  Free blocks at the end of the arena are given back to
+// the arena.  `heap_reset` frees everything at once.
+
+extern unsigned char __heap_base;
+
+#define HEADER_SIZE 16
+#define MIN_CLASS 5 // 32 bytes
+#define SMALL_MAX 4096
+#define N_CLASSES 32
+#define LARGE_CLASS N_CLASSES
+#define PAGE_SIZE 65536
+
+typedef struct FreeBlock {
+  struct FreeBlock* next;
+} FreeBlock;
+
+// The header of a large block (the first 16 bytes of the block).
+// `next` is only used while the block is free.
+typedef struct LargeBlock {
+  int c; // LARGE_CLASS
+  size_t size; // including the header
+  struct LargeBlock* next;
+} LargeBlock;
 
-  if (dst_ == src_ || n == 0) {
-    // do nothing
-  } else if (dst_ > src_) { // Is this condition ok also for corner cases?
-    for (long i = n - 1; i != -1; i--) {
-      dst_[i] = src_[i];
+static FreeBlock* freeLists[N_CLASSES];
+static LargeBlock* freeLarge = 0;
+static size_t arenaEnd = 0; // 0 means "not yet initialized"
+
+static size_t arenaStart() {
+  return ((size_t) &__heap_base + 15) & ~(size_t) 15;
+}
+
+// The smallest class c with 2^c >= total.
+static int sizeClass(size_t total) {
+  const int c = 32 - __builtin_clz((unsigned int) total - 1);
+  return c < MIN_CLASS ? MIN_CLASS : c;
+}
+
+static byte_ptr_t arenaAlloc(size_t size) {
+  if (arenaEnd == 0) {
+    arenaEnd = arenaStart();
+  }
+  const size_t start = arenaEnd;
+  const unsigned long long end = (unsigned long long) start + size;
+  const unsigned long long available =
+    (unsigned long long) __builtin_wasm_memory_size(0) * PAGE_SIZE;
+  if (end > available) {
+    const size_t pages = (end - available + PAGE_SIZE - 1) / PAGE_SIZE;
+    if (__builtin_wasm_memory_grow(0, pages) == (size_t) -1) {
+      return 0;
     }
+  }
+  arenaEnd = end;
+  return (byte_ptr_t) start;
+}
+
+// Give a free large block at the end of the arena back to the arena.
+static void trimArena() {
+  LargeBlock** link = &freeLarge;
+  if (!*link) {
+    return;
+  }
+  while ((*link)->next) {
+    link = &(*link)->next;
+  }
+  if ((size_t) *link + (*link)->size == arenaEnd) {
+    arenaEnd = (size_t) *link;
+    *link = 0;
+  }
+}
+
+static byte_ptr_t largeAlloc(size_t size) {
+  LargeBlock** bestLink = 0;
+  for (LargeBlock** link = &freeLarge; *link; link = &(*link)->next) {
+    if ((*link)->size >= size && (!bestLink || (*link)->size < (*bestLink)->size)) {
+      bestLink = link;
+    }
+  }
+  if (!bestLink) {
+    LargeBlock* block = (LargeBlock*) arenaAlloc(size);
+    if (block) {
+      block->c = LARGE_CLASS;
+      block->size = size;
+    }
+    return (byte_ptr_t) block;
+  }
+  LargeBlock* block = *bestLink;
+  if (block->size - size >= SMALL_MAX) {
+    LargeBlock* rest = (LargeBlock*) ((byte_ptr_t) block + size);
+    rest->c = LARGE_CLASS;
+    rest->size = block->size - size;
+    rest->next = block->next;
+    *bestLink = rest;
+    block->size = size;
+  } else {
+    *bestLink = block->next;
+  }
+  return (byte_ptr_t) block;
+}
+
+static void largeFree(LargeBlock* block) {
+  LargeBlock* prev = 0;
+  LargeBlock** link = &freeLarge;
+  while (*link && *link < block) {
+    prev = *link;
+    link = &(*link)->next;
+  }
+  LargeBlock* next = *link;
+  if (next && (byte_ptr_t) block + block->size == (byte_ptr_t) next) {
+    block->size += next->size;
+    next = next->next;
+  }
+  block->next = next;
+  *link = block;
+  if (prev && (byte_ptr_t) prev + prev->size == (byte_ptr_t) block) {
+    prev->size += block->size;
+    prev->next = block->next;
+  }
+  trimArena();
+}
+
+void* malloc(size_t n) {
+  if (n > ((size_t) 1 << (N_CLASSES - 1)) - HEADER_SIZE) {
+    return 0;
+  }
+  const size_t total = n + HEADER_SIZE;
+  if (total > SMALL_MAX) {
+    const byte_ptr_t block = largeAlloc((total + 15) & ~(size_t) 15);
+    return block ? block + HEADER_SIZE : 0;
+  }
+  const int c = sizeClass(total);
+  byte_ptr_t block = (byte_ptr_t) freeLists[c];
+  if (block) {
+    freeLists[c] = freeLists[c]->next;
   } else {
-    for (size_t i = 0; i < n; i++) {
-      dst_[i] = src_[i];
+    block = arenaAlloc((size_t) 1 << c);
+    if (!block) {
+      return 0;
     }
   }
-  return dst;
+  *(int*) block = c;
+  return block + HEADER_SIZE;
 }
 
-// We might also provide malloc/free here
-// - home-grown or
-// - Doug Lea's malloc or
-// - something a simplistic as the malloc in
-//   https://surma.dev/things/c-to-webassembly/
+void free(void* p) {
+  if (!p) {
+    return;
+  }
+  byte_ptr_t block = (byte_ptr_t) p - HEADER_SIZE;
+  const int c = *(int*) block;
+  if (c == LARGE_CLASS) {
+    largeFree((LargeBlock*) block);
+  } else if ((size_t) block + ((size_t) 1 << c) == arenaEnd) {
+    arenaEnd = (size_t) block;
+    trimArena();
+  } else {
+    FreeBlock* freeBlock = (FreeBlock*) block;
+    freeBlock->next = freeLists[c];
+    freeLists[c] = freeBlock;
+  }
+}
+
+void heap_reset() {
+  for (int c = 0; c < N_CLASSES; c++) {
+    freeLists[c] = 0;
+  }
+  freeLarge = 0;
+  arenaEnd = arenaStart();
+}
+
+// C++ operators new and delete (by their mangled names)
+// Without exceptions, new traps when malloc fails: the compiler assumes
+// that it never returns a null pointer and drops any checks for it.
+static void* allocateOrTrap(size_t n) {
+  void* p = malloc(n);
+  if (!p) {
+    __builtin_trap();
+  }
+  return p;
+}
+void* _Znwm(size_t n) { return allocateOrTrap(n); }   // new
+void* _Znam(size_t n) { return allocateOrTrap(n); }   // new[]
+void _ZdlPv(void* p) { free(p); }              // delete
+void _ZdaPv(void* p) { free(p); }              // delete[]
+void _ZdlPvm(void* p, size_t n) { free(p); }   // sized delete
+void _ZdaPvm(void* p, size_t n) { free(p); }   // sized delete[]
+
+#undef HEADER_SIZE
+#undef MIN_CLASS
+#undef SMALL_MAX
+#undef N_CLASSES
+#undef LARGE_CLASS
+#undef PAGE_SIZE
+
+#endif
@@ -0,0 +1,419 @@
+#include "ntt.h++"
+#include "tables.h++"
+#include <stdint.h>
+
+typedef unsigned __int128 uint128_t;
+
+// p = c * 2^k + 1 with primitive root g.  All three primes support
+// transforms of up to 2^54 points.
+static const struct {
+  uint64_t p;
+  uint64_t g;
+} nttPrimes[nttPrimeCount] = {
+  {  29ull << 57 | 1, 3}, // 4179340454199820289
+  {  69ull << 55 | 1, 5}, // 2485986994308513793
+  { 163ull << 54 | 1, 3}, // 2936346957045563393
+};
+
+// Plain modular arithmetic for precomputations
+
+static uint64_t mulMod(uint64_t a, uint64_t b, uint64_t p) {
+  return (uint64_t) ((uint128_t) a * b % p);
+}
+
+static uint64_t powMod(uint64_t a, uint64_t e, uint64_t p) {
+  uint64_t result = 1;
+  for (; e; e >>= 1, a = mulMod(a, a, p)) {
+    if (e & 1) {
+      result = mulMod(result, a, p);
+    }
+  }
+  return result;
+}
+
+static Modulus makeModulus(uint64_t p) {
+  // Newton iteration for p^(-1) mod 2^64 (each step doubles the number of
+  // correct bits, starting with 3 bits since p * p == 1 mod 8)
+  uint64_t inverse = p;
+  for (int i = 0; i < 5; i++) {
+    inverse *= 2 - p * inverse;
+  }
+  const uint64_t r = (uint64_t) (((uint128_t) 1 << 64) % p);
+  return Modulus{p, -inverse, mulMod(r, r, p)};
+}
+
+// Arithmetic on residues in [0, p)
+//
+// The conditional corrections are written with masks rather than
+// comparisons: the compiler turns the latter into branches, which
+// mispredict half of the time for random residues.  (Since p < 2^62,
+// a negative intermediate result has its top bit set.)
+
+static inline uint64_t correct(const Modulus& m, uint64_t a) {
+  return a + (m.p & -(a >> 63));
+}
+
+static inline uint64_t addMod(const Modulus& m, uint64_t a, uint64_t b) {
+  return correct(m, a + b - m.p);
+}
+
+static inline uint64_t subMod(const Modulus& m, uint64_t a, uint64_t b) {
+  return correct(m, a - b);
+}
+
+// a * b * 2^(-64) mod p
+// (No overflow since a * b + q * p < 2^124 + 2^126 for p < 2^62.)
+static inline uint64_t montMul(const Modulus& m, uint64_t a, uint64_t b) {
+  const uint128_t t = (uint128_t) a * b;
+  const uint64_t q = (uint64_t) t * m.negInverse;
+  const uint64_t u = (uint64_t) ((t + (uint128_t) q * m.p) >> 64);
+  return correct(m, u - m.p);
+}
+
+// a mod p for any 64-bit a (a < 8p since p > 2^61)
+static inline uint64_t reduce(const Modulus& m, uint64_t a) {
+  const uint64_t p4 = m.p << 2;
+  const uint64_t p2 = m.p << 1;
+  a = a >= p4 ? a - p4 : a;
+  a = a >= p2 ? a - p2 : a;
+  return a >= m.p ? a - m.p : a;
+}
+
+// Inside the transform, values are only reduced to [0, 2p), which saves
+// the correction step of the Montgomery multiplication.
+
+static inline uint64_t lazyCorrect(const Modulus& m, uint64_t a) {
+  return a + ((m.p << 1) & -(a >> 63));
+}
+
+static inline uint64_t lazyAdd(const Modulus& m, uint64_t a, uint64_t b) {
+  return lazyCorrect(m, a + b - (m.p << 1));
+}
+
+static inline uint64_t lazySub(const Modulus& m, uint64_t a, uint64_t b) {
+  return lazyCorrect(m, a - b);
+}
+
+// a * b * 2^(-64) mod p in [0, 2p) for a < 4p and b < p
+static inline uint64_t lazyMul(const Modulus& m, uint64_t a, uint64_t b) {
+  const uint128_t t = (uint128_t) a * b;
+  const uint64_t q = (uint64_t) t * m.negInverse;
+  return (uint64_t) ((t + (uint128_t) q * m.p) >> 64);
+}
+
+static inline uint64_t toMontgomery(const Modulus& m, uint64_t a) {
+  return montMul(m, a, m.r2);
+}
+
+NTT::NTT(unsigned int n, unsigned int prime) {
+  const Modulus mod = makeModulus(nttPrimes[prime].p);
+  const uint64_t p = mod.p;
+
+  uint64_t* roots = new uint64_t[n];
+  const uint64_t w = toMontgomery(mod, powMod(nttPrimes[prime].g, (p - 1) / n, p));
+  uint64_t power = toMontgomery(mod, 1);
+  for (unsigned int i = 0; i < n; i++) {
+    roots[i] = power;
+    power = montMul(mod, power, w);
+  }
+
+  const unsigned int quarterN = n >> 2;
+  unsigned int* permute = new unsigned int[quarterN];
+  fillBitReversal(permute, quarterN, quarterN);
+
+  this->n = n;
+  this->mod = mod;
+  this->roots = roots;
+  this->permute = permute;
+}
+
+NTT::~NTT() {
+  delete[] roots;
+  delete[] permute;
+}
+
+void NTT::run(const uint64_t* f, uint64_t* out, int direction) const {
+  const unsigned int n = this->n;
+  const Modulus& mod = this->mod;
+  switch (n) {
+    case 1: {
+      out[0] = f[0];
+      return;
+    }
+    case 2: {
+      const uint64_t a0 = f[0];
+      const uint64_t a1 = f[1];
+      out[0] = addMod(mod, a0, a1);
+      out[1] = subMod(mod, a0, a1);
+      return;
+    }
+  }
+  const uint64_t* const roots = this->roots;
+  const unsigned int* const permute = this->permute;
+
+  const unsigned int nMask = n - 1;
+  const unsigned int quarterN = n >> 2;
+
+#define root(x) roots[(x) & nMask]
+#define add(a, b) lazyAdd(mod, a, b)
+#define sub(a, b) lazySub(mod, a, b)
+#define mul(a, b) lazyMul(mod, a, b)
+
+  // corresponds to `rot90(...) * negDirection` in fft47
+  const uint64_t quarterTurn = root(-direction * (int) quarterN);
+
+  for (unsigned int out_offset = 0; out_offset < n;) {
+    unsigned int offset = permute[out_offset >> 2];
+    const uint64_t b0 = f[offset]; offset += quarterN;
+    const uint64_t b2 = f[offset]; offset += quarterN;
+    const uint64_t b1 = f[offset]; offset += quarterN;
+    const uint64_t b3 = f[offset];
+
+    const uint64_t c0 = add(b0, b1);
+    const uint64_t c1 = sub(b0, b1);
+    const uint64_t c2 = add(b2, b3);
+    const uint64_t c3 = mul(sub(b2, b3), quarterTurn);
+
+    out[out_offset++] = add(c0, c2);
+    out[out_offset++] = add(c1, c3);
+    out[out_offset++] = sub(c0, c2);
+    out[out_offset++] = sub(c1, c3);
+  }
+
+  unsigned int len = 8;
+  int rStride = direction * (n >> 3);
+  for (; len < n; len <<= 2, rStride >>= 2) {
+    const unsigned int halfLen = len >> 1;
+    for (unsigned int out_offset = 0; out_offset < n;) {
+      unsigned int i0 = out_offset; out_offset += halfLen;
+      unsigned int i1 = out_offset; out_offset += halfLen;
+      unsigned int i2 = out_offset; out_offset += halfLen;
+      unsigned int i3 = out_offset; out_offset += halfLen;
+
+      const uint64_t b0 = out[i0];
+      const uint64_t b1 = out[i1];
+      const uint64_t b2 = out[i2];
+      const uint64_t b3 = out[i3];
+
+      const uint64_t c0 = add(b0, b1);
+      const uint64_t c1 = sub(b0, b1);
+      const uint64_t c2 = add(b2, b3);
+      const uint64_t c3 = mul(sub(b2, b3), quarterTurn);
+
+      out[i0] = add(c0, c2);
+      out[i1] = add(c1, c3);
+      out[i2] = sub(c0, c2);
+      out[i3] = sub(c1, c3);
+    }
+    const int rStride1 = rStride >> 1;
+    const int rStride2 = rStride;
+    const int rStride3 = rStride2 + rStride1;
+    int rOffset1 = -rStride1;
+    int rOffset2 = -rStride2;
+    int rOffset3 = -rStride3;
+    for (unsigned int k = 1; k < halfLen; k++) {
+      const uint64_t r1 = root(rOffset1); rOffset1 -= rStride1;
+      const uint64_t r2 = root(rOffset2); rOffset2 -= rStride2;
+      const uint64_t r3 = root(rOffset3); rOffset3 -= rStride3;
+      for (unsigned int out_offset = k; out_offset < n;) {
+        unsigned int i0 = out_offset; out_offset += halfLen;
+        unsigned int i1 = out_offset; out_offset += halfLen;
+        unsigned int i2 = out_offset; out_offset += halfLen;
+        unsigned int i3 = out_offset; out_offset += halfLen;
+
+        const uint64_t b0 = out[i0];
+        const uint64_t b1 = mul(out[i1], r2);
+        const uint64_t b2 = mul(out[i2], r1);
+        const uint64_t b3 = mul(out[i3], r3);
+
+        const uint64_t c0 = add(b0, b1);
+        const uint64_t c1 = sub(b0, b1);
+        const uint64_t c2 = add(b2, b3);
+        const uint64_t c3 = mul(sub(b2, b3), quarterTurn);
+
+        out[i0] = add(c0, c2);
+        out[i1] = add(c1, c3);
+        out[i2] = sub(c0, c2);
+        out[i3] = sub(c1, c3);
+      }
+    }
+  }
+  if (len == n) {
+    // If we come here, n is not a power of 4 (but still a power of 2).
+    // So we need to run one extra round of 2-way butterflies.
+    const unsigned int halfLen = len >> 1;
+    {
+      const uint64_t z0 = out[0];
+      const uint64_t z1 = out[halfLen];
+
+      out[0]       = add(z0, z1);
+      out[halfLen] = sub(z0, z1);
+    }
+    int rOffset = -rStride;
+    for (unsigned int k0 = 1, k1 = halfLen + 1; k0 < halfLen; k0++, k1++) {
+      const uint64_t r = root(rOffset); rOffset -= rStride;
+
+      const uint64_t z0 = out[k0];
+      const uint64_t z1 = mul(out[k1], r);
+
+      out[k0] = add(z0, z1);
+      out[k1] = sub(z0, z1);
+    }
+  }
+
+#undef mul
+#undef sub
+#undef add
+#undef root
+
+  for (unsigned int i = 0; i < n; i++) {
+    out[i] = correct(mod, out[i] - mod.p);
+  }
+}
+
+NTTConvolution::NTTConvolution(unsigned int maxLength, unsigned int nPrimes) {
+  unsigned int n = 1;
+  while (n < maxLength) {
+    n <<= 1;
+  }
+
+  this->n = n;
+  this->nPrimes = nPrimes;
+  for (unsigned int i = 0; i < nPrimes; i++) {
+    NTT* ntt = new NTT(n, i);
+    const Modulus& mod = ntt->getModulus();
+    const uint64_t nInverse = powMod(n, mod.p - 2, mod.p);
+    ntts[i] = ntt;
+    scales[i] = mulMod(nInverse, mod.r2, mod.p);
+    residues[i] = new uint64_t[n];
+    for (unsigned int j = i + 1; j < nPrimes; j++) {
+      const Modulus& modJ = makeModulus(nttPrimes[j].p);
+      const uint64_t inverse = powMod(mod.p % modJ.p, modJ.p - 2, modJ.p);
+      garnerFactors[i][j] = toMontgomery(modJ, inverse);
+    }
+  }
+  bufferA = new uint64_t[n];
+  bufferB = new uint64_t[n];
+}
+
+NTTConvolution::~NTTConvolution() {
+  for (unsigned int i = 0; i < nPrimes; i++) {
+    delete ntts[i];
+    delete[] residues[i];
+  }
+  delete[] bufferA;
+  delete[] bufferB;
+}
+
+int NTTConvolution::run(
+  const uint64_t* a, unsigned int na, const uint64_t* b, unsigned int nb, uint64_t* out
+) const {
+  if (na == 0 || nb == 0 || na + nb - 1 > n) {
+    return -1;
+  }
+  const unsigned int nOut = na + nb - 1;
+  // Squaring needs only one forward transform.
+  const bool square = a == b && na == nb;
+
+  for (unsigned int i = 0; i < nPrimes; i++) {
+    const NTT* ntt = ntts[i];
+    const Modulus& mod = ntt->getModulus();
+
+    uint64_t* const r = residues[i];
+    for (unsigned int j = 0; j < n; j++) {
+      r[j] = j < na ? reduce(mod, a[j]) : 0;
+    }
+    ntt->run(r, bufferA, 1);
+    if (!square) {
+      for (unsigned int j = 0; j < n; j++) {
+        r[j] = j < nb ? reduce(mod, b[j]) : 0;
+      }
+      ntt->run(r, bufferB, 1);
+    }
+    const uint64_t* const spectrumB = square ? bufferA : bufferB;
+    for (unsigned int j = 0; j < n; j++) {
+      bufferA[j] = montMul(mod, bufferA[j], spectrumB[j]);
+    }
+    ntt->run(bufferA, r, -1);
+    const uint64_t scale = scales[i];
+    for (unsigned int j = 0; j < nOut; j++) {
+      r[j] = montMul(mod, r[j], scale);
+    }
+  }
+
+  // Garner's algorithm: find digits t[i] < p_i with
+  //   c = t[0] + p_0 (t[1] + p_1 (t[2] + ...))
+  // and evaluate that in multi-word arithmetic.
+  Modulus mods[nttPrimeCount];
+  for (unsigned int i = 0; i < nPrimes; i++) {
+    mods[i] = ntts[i]->getModulus();
+  }
+  for (unsigned int k = 0; k < nOut; k++) {
+    uint64_t t[nttPrimeCount];
+    for (unsigned int i = 0; i < nPrimes; i++) {
+      const Modulus& mod = mods[i];
+      uint64_t v = residues[i][k];
+      for (unsigned int j = 0; j < i; j++) {
+        // t[j] < p_j < 2^62 < 2 p_i
+        const uint64_t tj = t[j] >= mod.p ? t[j] - mod.p : t[j];
+        v = montMul(mod, subMod(mod, v, tj), garnerFactors[j][i]);
+      }
+      t[i] = v;
+    }
+
+    uint64_t* const words = out + (size_t) k * nPrimes;
+    for (unsigned int w = 0; w < nPrimes; w++) {
+      words[w] = 0;
+    }
+    words[0] = t[nPrimes - 1];
+    for (int i = nPrimes - 2; i >= 0; i--) {
+      uint128_t carry = t[i];
+      for (unsigned int w = 0; w < nPrimes; w++) {
+        const uint128_t x = (uint128_t) words[w] * mods[i].p + carry;
+        words[w] = (uint64_t) x;
+        carry = x >> 64;
+      }
+    }
+  }
+  return 0;
+}
+
+extern "C" {
+  uint64_t ntt_prime(unsigned int prime) {
+    return prime < nttPrimeCount ? nttPrimes[prime].p : 0;
+  }
+
+  NTT* prepare_ntt(unsigned int n, unsigned int prime) {
+    if (n == 0 || (n & (n - 1)) != 0 || prime >= nttPrimeCount) {
+      return 0;
+    }
+    return new NTT(n, prime);
+  }
+
+  void run_ntt(NTT* ntt, const uint64_t* input, uint64_t* output, int direction) {
+    ntt->run(input, output, direction);
+  }
+
+  void delete_ntt(NTT* ntt) {
+    delete ntt;
+  }
+
+  NTTConvolution* prepare_ntt_convolution(unsigned int maxLength, unsigned int nPrimes) {
+    if (nPrimes == 0 || nPrimes > nttPrimeCount || maxLength > 1u << 31) {
+      return 0;
+    }
+    return new NTTConvolution(maxLength, nPrimes);
+  }
+
+  int ntt_convolve(
+    NTTConvolution* conv,
+    const uint64_t* a, unsigned int na, const uint64_t* b, unsigned int nb,
+    uint64_t* out
+  ) {
+    return conv->run(a, na, b, nb, out);
+  }
+
+  void delete_ntt_convolution(NTTConvolution* conv) {
+    delete conv;
+  }
+}
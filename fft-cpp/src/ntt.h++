@@ -0,0 +1,109 @@
+#ifndef NTT_HPP
+#define NTT_HPP 1
+
+#include <stdint.h>
+
+// Number-theoretic transforms and exact integer convolution.
+//
+// An NTT is a DFT over the integers modulo a prime p = c * 2^k + 1, where
+// a primitive n-th root of unity w exists for every power of 2 n <= 2^k.
+// Since the arithmetic is exact, so are convolutions computed with it,
+// as long as the true results are smaller than p (or, with the Chinese
+// remainder theorem, smaller than the product of several such primes).
+//
+// The engine has the structure of fft47 (radix-4 stages, the first pass
+// reading through `permute`, a final radix-2 stage for odd powers of 2),
+// with the cosines table replaced by a table of the powers of w and
+// "rot90" replaced by a multiplication with w^(n/4).
+//
+// The primes are between 2^61 and 2^62 (see `nttPrimes` in ntt.c++).
+// Products are reduced with Montgomery multiplication (R = 2^64), which
+// needs a 64x64->128 bit multiplication but no division.  The twiddle
+// factors are kept in Montgomery form, so that multiplying a plain residue
+// with a twiddle factor gives a plain residue.
+
+struct Modulus {
+  uint64_t p;
+  // -p^(-1) mod 2^64
+  uint64_t negInverse;
+  // 2^128 mod p
+  uint64_t r2;
+};
+
+const unsigned int nttPrimeCount = 3;
+
+class NTT {
+  unsigned int n;
+  Modulus mod;
+  // roots[i] = w^i (in Montgomery form) for the primitive n-th root w
+  uint64_t* roots;
+  unsigned int* permute;
+
+public:
+  // n must be a power of 2.  `prime` selects one of the primes
+  // (0 <= prime < nttPrimeCount).
+  NTT(unsigned int n, unsigned int prime);
+  ~NTT();
+
+  // X[k] = sum_j f[j] w^(-direction j k) mod p
+  // The inputs must be reduced modulo p, and so are the outputs.
+  // As with the FFT engines, the inverse transform is not scaled by 1/n.
+  void run(const uint64_t* f, uint64_t* out, int direction = 1) const;
+
+  const Modulus& getModulus() const { return mod; }
+};
+
+// Convolution of non-negative 64-bit integer sequences:
+//   c[k] = sum_{i+j=k} a[i] b[j]
+// computed modulo each of `nPrimes` primes (1 to 3) and combined with
+// Garner's algorithm.  Each result is written as `nPrimes` 64-bit words
+// (least significant first).  The results are exact if they are smaller
+// than the product of the primes (about 2^61 to the power of nPrimes),
+// e.g., for 3 primes if min(na, nb) * max(a)* max(b) < 2^183.
+class NTTConvolution {
+  unsigned int n;
+  unsigned int nPrimes;
+  NTT* ntts[nttPrimeCount];
+
+  // per prime: (2^128 / n) mod p, which also undoes the factor 2^(-64)
+  // of the Montgomery multiplication of the spectra
+  uint64_t scales[nttPrimeCount];
+  // garnerFactors[i][j] = p_i^(-1) mod p_j (in Montgomery form) for i < j
+  uint64_t garnerFactors[nttPrimeCount][nttPrimeCount];
+
+  // pre-allocated buffers
+  uint64_t* bufferA;
+  uint64_t* bufferB;
+  uint64_t* residues[nttPrimeCount];
+
+public:
+  // maxLength is the maximum of na + nb - 1 in calls of `run`.
+  NTTConvolution(unsigned int maxLength, unsigned int nPrimes);
+  ~NTTConvolution();
+
+  // Writes na + nb - 1 results (of nPrimes words each) to `out`.
+  // Returns 0 on success and -1 if the sequences are too long (or empty).
+  int run(const uint64_t* a, unsigned int na, const uint64_t* b, unsigned int nb, uint64_t* out) const;
+};
+
+extern "C" {
+  // The prime with the given index (or 0 for an invalid index).
+  uint64_t ntt_prime(unsigned int prime);
+
+  // A null pointer if n is not a power of 2 or `prime` is invalid.
+  NTT* prepare_ntt(unsigned int n, unsigned int prime);
+  void run_ntt(NTT* ntt, const uint64_t* input, uint64_t* output, int direction);
+  void delete_ntt(NTT* ntt);
+
+  // A null pointer if nPrimes is not between 1 and nttPrimeCount or
+  // maxLength exceeds 2^31.
+  NTTConvolution* prepare_ntt_convolution(unsigned int maxLength, unsigned int nPrimes);
+  int ntt_convolve(
+    NTTConvolution* conv,
+    const uint64_t* a, unsigned int na, const uint64_t* b, unsigned int nb,
+    uint64_t* out
+  );
+  void delete_ntt_convolution(NTTConvolution* conv);
+}
+
+#endif
@@ -0,0 +1,224 @@
+#include "outOfCore.h++"
+#include "complex.h++"
+#include "c_bindings.h++"
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const double TAU = 6.2831853071795864769;
+
+OutOfCoreFFT::OutOfCoreFFT(uint64_t n, uint64_t memoryBudget) {
+  unsigned int log2n = 0;
+  while (((uint64_t) 1 << log2n) < n) {
+    log2n++;
+  }
+  const unsigned int n1 = 1u << (log2n >> 1);
+  const unsigned int n2 = (unsigned int) (n / n1);
+
+  // A panel holds `panelWidth` columns of `n1` or `n2` complex numbers.
+  // One more column is needed for the working buffer.
+  const unsigned int maxLen = n2 > n1 ? n2 : n1;
+  uint64_t panelWidth = memoryBudget / (sizeof(Complex) * (uint64_t) maxLen);
+  panelWidth = panelWidth > 1 ? panelWidth - 1 : 1;
+  const unsigned int panelWidth1 = panelWidth < n2 ? panelWidth : n2;
+  const unsigned int panelWidth2 = panelWidth < n1 ? panelWidth : n1;
+
+  Complex* coarse = new Complex[n1];
+  for (unsigned int q = 0; q < n1; q++) {
+    coarse[q] = expi(TAU * q / n1);
+  }
+  Complex* fine = new Complex[n2];
+  for (unsigned int r = 0; r < n2; r++) {
+    fine[r] = expi(TAU * r / n);
+  }
+
+  const uint64_t panelSize1 = (uint64_t) panelWidth1 * n1;
+  const uint64_t panelSize2 = (uint64_t) panelWidth2 * n2;
+
+  this->n = n;
+  this->n1 = n1;
+  this->n2 = n2;
+  this->panelWidth1 = panelWidth1;
+  this->panelWidth2 = panelWidth2;
+  this->fft1 = prepare_fft(n1);
+  this->fft2 = prepare_fft(n2);
+  this->coarse = coarse;
+  this->fine = fine;
+  this->panel = new Complex[panelSize1 > panelSize2 ? panelSize1 : panelSize2];
+  this->work = new Complex[maxLen];
+}
+
+OutOfCoreFFT::~OutOfCoreFFT() {
+  delete_fft(fft1);
+  delete_fft(fft2);
+  delete[] coarse;
+  delete[] fine;
+  delete[] panel;
+  delete[] work;
+}
+
+void OutOfCoreFFT::run(const Complex* f, Complex* out, int direction) const {
+  const uint64_t n = this->n;
+  const unsigned int n1 = this->n1;
+  const unsigned int n2 = this->n2;
+  const Complex* const coarse = this->coarse;
+  const Complex* const fine = this->fine;
+  Complex* const panel = this->panel;
+  Complex* const work = this->work;
+
+  // n2 is a power of 2
+  const uint64_t n2Mask = n2 - 1;
+  unsigned int n2Shift = 0;
+  while ((1u << n2Shift) < n2) {
+    n2Shift++;
+  }
+
+  // Pass 1: f is an n1 x n2 matrix; out becomes an n2 x n1 matrix.
+  for (unsigned int col = 0; col < n2; col += panelWidth1) {
+    const unsigned int width = n2 - col < panelWidth1 ? n2 - col : panelWidth1;
+
+    // Read a contiguous chunk from each row and store it transposed.
+    for (unsigned int row = 0; row < n1; row++) {
+      const Complex* chunk = f + (uint64_t) row * n2 + col;
+      for (unsigned int t = 0; t < width; t++) {
+        panel[(uint64_t) t * n1 + row] = chunk[t];
+      }
+    }
+
+    for (unsigned int t = 0; t < width; t++) {
+      run_fft(fft1, panel + (uint64_t) t * n1, work, direction);
+
+      // The twiddle factor for element (k1, j2) is e^(-direction * i TAU m/n)
+      // with m = k1 * j2 mod n.  We step through m incrementally.
+      const uint64_t j2 = col + t;
+      Complex* outRow = out + j2 * n1;
+      uint64_t m = 0;
+      for (unsigned int k1 = 0; k1 < n1; k1++) {
+        const Complex w = coarse[m >> n2Shift] * fine[m & n2Mask];
+        outRow[k1] = work[k1] * Complex(w.real(), -direction * w.imag());
+        m += j2;
+        if (m >= n) {
+          m -= n;
+        }
+      }
+    }
+  }
+
+  // Pass 2: transform the columns of out in place.
+  for (unsigned int col = 0; col < n1; col += panelWidth2) {
+    const unsigned int width = n1 - col < panelWidth2 ? n1 - col : panelWidth2;
+
+    for (unsigned int row = 0; row < n2; row++) {
+      const Complex* chunk = out + (uint64_t) row * n1 + col;
+      for (unsigned int t = 0; t < width; t++) {
+        panel[(uint64_t) t * n2 + row] = chunk[t];
+      }
+    }
+
+    for (unsigned int t = 0; t < width; t++) {
+      Complex* column = panel + (uint64_t) t * n2;
+      run_fft(fft2, column, work, direction);
+      for (unsigned int k2 = 0; k2 < n2; k2++) {
+        column[k2] = work[k2];
+      }
+    }
+
+    for (unsigned int row = 0; row < n2; row++) {
+      Complex* chunk = out + (uint64_t) row * n1 + col;
+      for (unsigned int t = 0; t < width; t++) {
+        chunk[t] = panel[(uint64_t) t * n2 + row];
+      }
+    }
+  }
+}
+
+int OutOfCoreFFT::runFiles(const char* inputPath, const char* outputPath, int direction) const {
+  const uint64_t size = n * sizeof(Complex);
+
+  const int inFd = open(inputPath, O_RDONLY);
+  if (inFd < 0) {
+    return -1;
+  }
+  struct stat st;
+  if (fstat(inFd, &st) < 0) {
+    close(inFd);
+    return -1;
+  }
+  if ((uint64_t) st.st_size != size) {
+    close(inFd);
+    errno = EINVAL;
+    return -1;
+  }
+
+  // Truncate only after checking that the output is not the input.
+  const int outFd = open(outputPath, O_RDWR | O_CREAT, 0644);
+  if (outFd < 0) {
+    close(inFd);
+    return -1;
+  }
+  struct stat outSt;
+  if (fstat(outFd, &outSt) < 0) {
+    close(outFd);
+    close(inFd);
+    return -1;
+  }
+  if (outSt.st_dev == st.st_dev && outSt.st_ino == st.st_ino) {
+    close(outFd);
+    close(inFd);
+    errno = EINVAL;
+    return -1;
+  }
+  if (ftruncate(outFd, 0) < 0 || ftruncate(outFd, size) < 0) {
+    close(outFd);
+    close(inFd);
+    return -1;
+  }
+
+  void* input = mmap(0, size, PROT_READ, MAP_SHARED, inFd, 0);
+  void* output = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, outFd, 0);
+  int result = 0;
+  if (input == MAP_FAILED || output == MAP_FAILED) {
+    result = -1;
+  } else {
+    // No access hints: pass 1 reads a chunk of every row for each panel,
+    // which is not sequential.
+    run((const Complex*) input, (Complex*) output, direction);
+  }
+
+  const int savedErrno = errno;
+  if (output != MAP_FAILED) {
+    munmap(output, size);
+  }
+  if (input != MAP_FAILED) {
+    munmap(input, size);
+  }
+  close(outFd);
+  close(inFd);
+  errno = savedErrno;
+  return result;
+}
+
+extern "C" {
+  OutOfCoreFFT* prepare_fft_ooc(uint64_t n, uint64_t memoryBudget) {
+    if (n == 0 || (n & (n - 1)) != 0 || n > maxOutOfCoreN) {
+      errno = EINVAL;
+      return 0;
+    }
+    return new OutOfCoreFFT(n, memoryBudget);
+  }
+
+  void run_fft_ooc(OutOfCoreFFT* fft, const Complex* input, Complex* output, int direction) {
+    fft->run(input, output, direction);
+  }
+
+  int run_fft_ooc_files(OutOfCoreFFT* fft, const char* inputPath, const char* outputPath, int direction) {
+    return fft->runFiles(inputPath, outputPath, direction);
+  }
+
+  void delete_fft_ooc(OutOfCoreFFT* fft) {
+    delete fft;
+  }
+}
@@ -0,0 +1,68 @@
+#ifndef OUT_OF_CORE_HPP
+#define OUT_OF_CORE_HPP 1
+
+#include <stdint.h>
+
+#include "complex.h++"
+#include "c_bindings.h++"
+
+// The largest size of an out-of-core FFT.
+const uint64_t maxOutOfCoreN = (uint64_t) 1 << 62;
+
+// An FFT for data that need not fit into RAM, typically memory-mapped files.
+//
+// The transformation uses the "six-step" decomposition n = n1 * n2:
+// - Pass 1 reads the input as an n1 x n2 matrix in panels of columns,
+//   runs n1-point FFTs on the columns, multiplies with twiddle factors
+//   and writes the results as rows of an n2 x n1 matrix to the output.
+// - Pass 2 reads the output in panels of columns, runs n2-point FFTs on
+//   the columns and writes the results back to the same places.
+// So every element is read and written twice, independently of n.
+// The sub-FFTs are computed in core with the version this code is linked
+// with.
+//
+// n must be a power of 2 and at most `maxOutOfCoreN` (so that n1 and n2
+// fit into 32 bits).  For other sizes `prepare_fft_ooc` returns a null
+// pointer and sets errno to EINVAL.
+// Sizes and offsets are 64-bit throughout.
+// The memory budget limits the size of the panels.
+// (It is a soft limit: at least one column is always processed at a time.)
+class OutOfCoreFFT {
+  uint64_t n;
+  unsigned int n1, n2;
+  unsigned int panelWidth1, panelWidth2;
+
+  FFT* fft1;
+  FFT* fft2;
+
+  // The twiddle factor e^(i TAU m/n) for m = q * n2 + r is
+  // coarse[q] * fine[r].
+  Complex* coarse;
+  Complex* fine;
+
+  // pre-allocated buffers
+  Complex* panel;
+  Complex* work;
+
+public:
+  OutOfCoreFFT(uint64_t n, uint64_t memoryBudget);
+  ~OutOfCoreFFT();
+
+  // `f` and `out` must not overlap.
+  void run(const Complex* f, Complex* out, int direction = 1) const;
+
+  // Returns 0 on success and -1 (with errno set) on failure.
+  // The input file must contain n complex numbers as pairs of doubles.
+  // The output file must be a different file (EINVAL otherwise, leaving
+  // the input intact).
+  int runFiles(const char* inputPath, const char* outputPath, int direction = 1) const;
+};
+
+extern "C" {
+  OutOfCoreFFT* prepare_fft_ooc(uint64_t n, uint64_t memoryBudget);
+  void run_fft_ooc(OutOfCoreFFT* fft, const Complex* input, Complex* output, int direction = 1);
+  int run_fft_ooc_files(OutOfCoreFFT* fft, const char* inputPath, const char* outputPath, int direction = 1);
+  void delete_fft_ooc(OutOfCoreFFT* fft);
+}
+
+#endif
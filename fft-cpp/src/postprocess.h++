@@ -0,0 +1,112 @@
+#ifndef POSTPROCESS_HPP
+#define POSTPROCESS_HPP 1
+
+#include <math.h>
+
+#include "complex.h++"
+#include "simd128.h++"
+
+// Post-processing fused into the last stage of an engine.
+//
+// A plan applies a scale factor (separately configurable for the forward
+// and the inverse direction) and one of the following output modes:
+// - FFT_OUTPUT_COMPLEX:   the scaled complex values
+// - FFT_OUTPUT_REAL:      the real parts only
+// - FFT_OUTPUT_POWER:     |X|^2
+// - FFT_OUTPUT_MAGNITUDE: |X|
+// - FFT_OUTPUT_LOG_POWER: 10 log10 |X|^2 (in dB)
+// The real-valued modes write n doubles to the beginning of the output
+// array (interpreted as `double*`), so that the caller reads half the
+// memory.  They compute the transform in a separate work area.
+//
+// The engines call the last stage with one of the following "outputs".
+// Each one stores a value computed for index i.
+
+#define FFT_OUTPUT_COMPLEX 0
+#define FFT_OUTPUT_REAL 1
+#define FFT_OUTPUT_POWER 2
+#define FFT_OUTPUT_MAGNITUDE 3
+#define FFT_OUTPUT_LOG_POWER 4
+
+struct ComplexOutput {
+  Complex* out;
+  inline void operator()(unsigned int i, VComplex z) const {
+    vstore(out + i, z);
+  }
+};
+
+struct ScaledOutput {
+  Complex* out;
+  double scale;
+  inline void operator()(unsigned int i, VComplex z) const {
+    vstore(out + i, z * scale);
+  }
+};
+
+struct RealOutput {
+  double* out;
+  double scale;
+  inline void operator()(unsigned int i, VComplex z) const {
+    out[i] = vreal(z) * scale;
+  }
+};
+
+struct PowerOutput {
+  double* out;
+  double scale2;
+  inline void operator()(unsigned int i, VComplex z) const {
+    out[i] = vnorm(z) * scale2;
+  }
+};
+
+struct MagnitudeOutput {
+  double* out;
+  double scale;
+  inline void operator()(unsigned int i, VComplex z) const {
+    out[i] = sqrt(vnorm(z)) * scale;
+  }
+};
+
+struct LogPowerOutput {
+  double* out;
+  double offset;
+  inline void operator()(unsigned int i, VComplex z) const {
+    out[i] = 10 * log10(vnorm(z)) + offset;
+  }
+};
+
+// Call `run` with the output for the given mode and scale.
+template <class Run>
+inline void withOutput(int mode, double scale, Complex* out, Run run) {
+  double* const values = (double*) out;
+  switch (mode) {
+    case FFT_OUTPUT_COMPLEX:
+      if (scale == 1) {
+        run(ComplexOutput{out});
+      } else {
+        run(ScaledOutput{out, scale});
+      }
+      break;
+    case FFT_OUTPUT_REAL:      run(RealOutput{values, scale}); break;
+    case FFT_OUTPUT_POWER:     run(PowerOutput{values, scale * scale}); break;
+    case FFT_OUTPUT_MAGNITUDE: run(MagnitudeOutput{values, fabs(scale)}); break;
+    case FFT_OUTPUT_LOG_POWER: run(LogPowerOutput{values, 20 * log10(fabs(scale))}); break;
+  }
+}
+
+class FFT;
+
+extern "C" {
+  // Select the post-processing for subsequent `run_fft` calls.
+  // Returns 0 on success and -1 for an unknown mode.
+  // (Only provided by engines supporting it.)
+  int set_fft_output(FFT* fft, int mode, double forwardScale, double inverseScale);
+
+  // Like `run_fft`, but the real-valued modes use `work` (n complex values,
+  // distinct from input and output) instead of a work area of the plan.
+  // `run_fft` in a real-valued mode is not reentrant, so threads sharing a
+  // plan must call this with a work area each.
+  void run_fft_with_work(FFT* fft, const Complex* input, Complex* output, int direction, Complex* work);
+}
+
+#endif
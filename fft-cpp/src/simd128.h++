@@ -0,0 +1,102 @@
+#ifndef SIMD128_HPP
+#define SIMD128_HPP 1
+
+#include "complex.h++"
+
+// Complex arithmetic on WebAssembly SIMD128 vectors,
+// one complex double (real and imaginary part) per v128.
+//
+// When compiling without `-msimd128` (native builds and the plain WASM
+// build) `VComplex` is just `Complex`.  So code written with `VComplex`,
+// `vload`, `vstore`, `vcomplex`, `vreal`, and `vnorm` compiles to the scalar
+// code there.
+
+#ifdef __wasm_simd128__
+
+#include <wasm_simd128.h>
+
+struct VComplex {
+  v128_t v;
+};
+
+inline VComplex vload(const Complex* p) {
+  return VComplex{wasm_v128_load(p)};
+}
+
+inline void vstore(Complex* p, VComplex z) {
+  wasm_v128_store(p, z.v);
+}
+
+inline VComplex vcomplex(double re, double im) {
+  return VComplex{wasm_f64x2_make(re, im)};
+}
+
+inline VComplex operator+(VComplex x, VComplex y) {
+  return VComplex{wasm_f64x2_add(x.v, y.v)};
+}
+
+inline VComplex operator-(VComplex x, VComplex y) {
+  return VComplex{wasm_f64x2_sub(x.v, y.v)};
+}
+
+inline VComplex operator*(VComplex x, double y) {
+  return VComplex{wasm_f64x2_mul(x.v, wasm_f64x2_splat(y))};
+}
+
+// XOR-ing with this flips the sign of the real part.
+#define NEGATE_RE wasm_f64x2_make(-0.0, 0.0)
+
+inline VComplex operator*(VComplex x, VComplex y) {
+  const v128_t y_re = wasm_i64x2_shuffle(y.v, y.v, 0, 0);
+  const v128_t y_im = wasm_i64x2_shuffle(y.v, y.v, 1, 1);
+  const v128_t x_swapped = wasm_i64x2_shuffle(x.v, x.v, 1, 0);
+  // (x_re * y_re, x_im * y_re) + (-x_im * y_im, x_re * y_im)
+  return VComplex{wasm_f64x2_add(
+    wasm_f64x2_mul(x.v, y_re),
+    wasm_v128_xor(wasm_f64x2_mul(x_swapped, y_im), NEGATE_RE)
+  )};
+}
+
+inline VComplex rot90(VComplex z) {
+  return VComplex{wasm_v128_xor(wasm_i64x2_shuffle(z.v, z.v, 1, 0), NEGATE_RE)};
+}
+
+#undef NEGATE_RE
+
+inline double vreal(VComplex z) {
+  return wasm_f64x2_extract_lane(z.v, 0);
+}
+
+// re^2 + im^2
+inline double vnorm(VComplex z) {
+  const v128_t squares = wasm_f64x2_mul(z.v, z.v);
+  return wasm_f64x2_extract_lane(squares, 0) + wasm_f64x2_extract_lane(squares, 1);
+}
+
+#else
+
+typedef Complex VComplex;
+
+inline VComplex vload(const Complex* p) {
+  return *p;
+}
+
+inline void vstore(Complex* p, const VComplex& z) {
+  *p = z;
+}
+
+inline VComplex vcomplex(double re, double im) {
+  return Complex(re, im);
+}
+
+inline double vreal(VComplex z) {
+  return z.real();
+}
+
+inline double vnorm(VComplex z) {
+  return z.real() * z.real() + z.imag() * z.imag();
+}
+
+#endif
+
+#endif
@@ -0,0 +1,121 @@
+#include "slidingDFT.h++"
+#include "complex.h++"
+#include "c_bindings.h++"
+#include "tables.h++"
+
+SlidingDFT::SlidingDFT(
+  unsigned int n, const unsigned int* bins, unsigned int nBins,
+  unsigned int resyncInterval, int direction
+) {
+  if (!bins) {
+    nBins = n;
+  }
+  unsigned int* ownBins = new unsigned int[nBins];
+  for (unsigned int j = 0; j < nBins; j++) {
+    ownBins[j] = (bins ? bins[j] : j) & (n - 1);
+  }
+
+  // The rotations only need the first quadrant of the cosines table.
+  const unsigned int quarterN = n >> 2;
+  double* cosines = new double[quarterN + 1];
+  fillCosines(cosines, n, quarterN + 1);
+  Complex* rotations = new Complex[nBins];
+  for (unsigned int j = 0; j < nBins; j++) {
+    const unsigned int x = direction * ownBins[j];
+    // (For n < 4 the rotations are 1 and -1.)
+    rotations[j] = quarterN > 0 ? unitRoot(cosines, n, x) : Complex((x & (n - 1)) ? -1 : 1, 0);
+  }
+  delete[] cosines;
+
+  Complex* spectrum = new Complex[nBins];
+  for (unsigned int j = 0; j < nBins; j++) {
+    spectrum[j] = 0;
+  }
+  Complex* window = new Complex[n];
+  for (unsigned int i = 0; i < n; i++) {
+    window[i] = 0;
+  }
+
+  this->n = n;
+  this->direction = direction;
+  this->nBins = nBins;
+  this->bins = ownBins;
+  this->rotations = rotations;
+  this->spectrum = spectrum;
+  this->window = window;
+  this->position = 0;
+  this->resyncInterval = resyncInterval;
+  this->untilResync = resyncInterval;
+  this->fft = prepare_fft(n);
+  this->fftInput = new Complex[n];
+  this->fftOutput = new Complex[n];
+}
+
+SlidingDFT::~SlidingDFT() {
+  delete_fft(fft);
+  delete[] bins;
+  delete[] rotations;
+  delete[] spectrum;
+  delete[] window;
+  delete[] fftInput;
+  delete[] fftOutput;
+}
+
+void SlidingDFT::push(const Complex* samples, unsigned int count) {
+  const unsigned int nBins = this->nBins;
+  const unsigned int nMask = n - 1;
+  const Complex* const rotations = this->rotations;
+  Complex* const spectrum = this->spectrum;
+  Complex* const window = this->window;
+
+  for (unsigned int s = 0; s < count; s++) {
+    const Complex delta = samples[s] - window[position];
+    window[position] = samples[s];
+    position = (position + 1) & nMask;
+
+    for (unsigned int j = 0; j < nBins; j++) {
+      spectrum[j] = (spectrum[j] + delta) * rotations[j];
+    }
+
+    if (resyncInterval > 0 && --untilResync == 0) {
+      resync();
+    }
+  }
+}
+
+void SlidingDFT::resync() {
+  // Bring the window into chronological order.
+  for (unsigned int i = 0, p = position; i < n; i++, p = (p + 1) & (n - 1)) {
+    fftInput[i] = window[p];
+  }
+  run_fft(fft, fftInput, fftOutput, direction);
+  for (unsigned int j = 0; j < nBins; j++) {
+    spectrum[j] = fftOutput[bins[j]];
+  }
+  untilResync = resyncInterval;
+}
+
+extern "C" {
+  SlidingDFT* prepare_sliding_dft(
+    unsigned int n, const unsigned int* bins, unsigned int nBins,
+    unsigned int resyncInterval, int direction
+  ) {
+    return new SlidingDFT(n, bins, nBins, resyncInterval, direction);
+  }
+
+  void sliding_dft_push(SlidingDFT* dft, const Complex* samples, unsigned int count) {
+    dft->push(samples, count);
+  }
+
+  void sliding_dft_resync(SlidingDFT* dft) {
+    dft->resync();
+  }
+
+  const Complex* sliding_dft_spectrum(const SlidingDFT* dft) {
+    return dft->getSpectrum();
+  }
+
+  void delete_sliding_dft(SlidingDFT* dft) {
+    delete dft;
+  }
+}
@@ -0,0 +1,67 @@
+#ifndef SLIDING_DFT_HPP
+#define SLIDING_DFT_HPP 1
+
+#include "complex.h++"
+#include "c_bindings.h++"
+
+// The DFT of the last n samples, updated with every new sample.
+//
+// When sample x_new enters the window and x_old drops out, each bin is
+// updated as
+//   X_k := (X_k - x_old + x_new) * e^(i TAU direction k / n)
+// which costs O(1) per tracked bin.  Either all n bins or a given subset
+// is tracked.
+//
+// The updates accumulate rounding errors.  So every `resyncInterval`
+// samples (0 means never) the spectrum is recomputed from the window with
+// the version this code is linked with.
+//
+// The window starts with n zeros.  n must be a power of 2.
+class SlidingDFT {
+  unsigned int n;
+  int direction;
+  unsigned int nBins;
+  unsigned int* bins;
+  // per-bin rotation factors, from a quadrant of cosines (see tables.h++)
+  Complex* rotations;
+  Complex* spectrum;
+
+  // circular buffer; `position` is the index of the oldest sample
+  Complex* window;
+  unsigned int position;
+
+  unsigned int resyncInterval;
+  unsigned int untilResync;
+
+  FFT* fft;
+  Complex* fftInput;
+  Complex* fftOutput;
+
+public:
+  // If `bins` is null, all n bins are tracked in their natural order.
+  SlidingDFT(
+    unsigned int n, const unsigned int* bins, unsigned int nBins,
+    unsigned int resyncInterval, int direction = 1
+  );
+  ~SlidingDFT();
+
+  void push(const Complex* samples, unsigned int count);
+  void resync();
+
+  // The current values of the tracked bins (in the order of `bins`).
+  const Complex* getSpectrum() const { return spectrum; }
+  unsigned int getBinCount() const { return nBins; }
+};
+
+extern "C" {
+  SlidingDFT* prepare_sliding_dft(
+    unsigned int n, const unsigned int* bins, unsigned int nBins,
+    unsigned int resyncInterval, int direction = 1
+  );
+  void sliding_dft_push(SlidingDFT* dft, const Complex* samples, unsigned int count);
+  void sliding_dft_resync(SlidingDFT* dft);
+  const Complex* sliding_dft_spectrum(const SlidingDFT* dft);
+  void delete_sliding_dft(SlidingDFT* dft);
+}
+
+#endif
@@ -0,0 +1,266 @@
+#ifndef TABLES_HPP
+#define TABLES_HPP 1
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "complex.h++"
+
+// Fast construction of the tables used by the engines, and plan images.
+//
+// Calling `cos()` for each of n table entries dominates the plan
+// construction for large n.  `fillCosines` only evaluates one octant and
+// gets the remaining values by symmetry.  Within the octant it evaluates
+// cosine and sine exactly at the start of each block of `cosineBlock`
+// entries and derives the other entries of the block with the addition
+// theorem from a small table of cosines and sines of j * TAU / n.
+// Since every value is only one step away from exactly evaluated values,
+// the error does not accumulate (a few ulps at most).
+//
+// `fillBitReversal` computes the bit-reversal permutation directly,
+// where the engines used to accumulate it over log2(n) passes.
+
+const unsigned int cosineBlock = 32;
+
+// cosines[i] = cos(TAU * i / n) for 0 <= i < count <= n,
+// where n is a power of 2 and count > n/4 (for n >= 4).
+inline void fillCosines(double* cosines, unsigned int n, unsigned int count) {
+  const double TAU = 6.2831853071795864769;
+  if (n < 4) {
+    for (unsigned int i = 0; i < count; i++) {
+      cosines[i] = i == 0 ? 1 : -1;
+    }
+    return;
+  }
+  const unsigned int quarterN = n >> 2;
+  const unsigned int halfN = n >> 1;
+  const unsigned int eighthN = n >> 3;
+  double blockCos[cosineBlock], blockSin[cosineBlock];
+  for (unsigned int j = 0; j < cosineBlock && j <= eighthN; j++) {
+    blockCos[j] = cos(TAU * j / n);
+    blockSin[j] = sin(TAU * j / n);
+  }
+  for (unsigned int base = 0; base <= eighthN; base += cosineBlock) {
+    const double c = cos(TAU * base / n);
+    const double s = sin(TAU * base / n);
+    for (unsigned int j = 0; j < cosineBlock && base + j <= eighthN; j++) {
+      // cos(x) in the first octant, sin(x) = cos(TAU/4 - x) in the second
+      cosines[base + j] = c * blockCos[j] - s * blockSin[j];
+      cosines[quarterN - base - j] = s * blockCos[j] + c * blockSin[j];
+    }
+  }
+  const unsigned int halfLimit = count < halfN + 1 ? count : halfN + 1;
+  for (unsigned int i = quarterN + 1; i < halfLimit; i++) {
+    cosines[i] = -cosines[halfN - i];
+  }
+  for (unsigned int i = halfN + 1; i < count; i++) {
+    cosines[i] = cosines[n - i];
+  }
+}
+
+// permute[i] = i with its log2(size) lowest bits reversed,
+// for 0 <= i < count <= size, where size is a power of 2.
+inline void fillBitReversal(unsigned int* permute, unsigned int count, unsigned int size) {
+  const unsigned int highBit = size >> 1;
+  if (count > 0) {
+    permute[0] = 0;
+  }
+  for (unsigned int i = 1; i < count; i++) {
+    permute[i] = (permute[i >> 1] >> 1) | ((i & 1) ? highBit : 0);
+  }
+}
+
+// e^(i TAU x / m) from the first quadrant of a cosines table for m
+// (cosines[i] for 0 <= i <= m/4, see `fillCosines`), where m >= 4.
+inline Complex unitRoot(const double* cosines, unsigned int m, unsigned int x) {
+  const unsigned int quarterM = m >> 2;
+  x &= m - 1;
+  const unsigned int r = x & (quarterM - 1);
+  const double c = cosines[r];
+  const double s = cosines[quarterM - r];
+  switch (x / quarterM) {
+    case 0:  return Complex( c,  s);
+    case 1:  return Complex(-s,  c);
+    case 2:  return Complex(-c, -s);
+    default: return Complex( s, -c);
+  }
+}
+
+// Plan images
+// -----------
+//
+// A plan image is a file with the tables of a plan, so that a process
+// can map it read-only instead of computing the tables.  The page cache
+// shares the tables among all processes mapping the same file.
+//
+// Layout: a PlanImageHeader, `nCosines` doubles, `nPermute` unsigned ints.
+// `engine` identifies the version (and thus the table layout).
+// Images use the native byte order and are only supported natively.
+
+struct PlanImageHeader {
+  char magic[8];
+  char engine[16];
+  uint32_t n;
+  uint32_t nCosines;
+  uint32_t nPermute;
+  uint32_t reserved;
+};
+
+struct PlanImage {
+  void* base;
+  size_t size;
+  unsigned int n;
+  unsigned int nCosines;
+  unsigned int nPermute;
+  const double* cosines;
+  const unsigned int* permute;
+};
+
+#if defined(__wasm__)
+
+inline int writePlanImage(
+  const char* path, const char* engine, unsigned int n,
+  const double* cosines, unsigned int nCosines,
+  const unsigned int* permute, unsigned int nPermute
+) {
+  return -1;
+}
+
+inline int mapPlanImage(const char* path, const char* engine, PlanImage* image) {
+  return -1;
+}
+
+inline void unmapPlanImage(const PlanImage* image) {}
+
+#else
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char planImageMagic[8] = {'F', 'F', 'T', 'P', 'L', 'A', 'N', '1'};
+
+// Returns 0 on success and -1 on failure.
+// The file is written under a temporary name and then renamed,
+// so that processes mapping `path` never see a partial image.
+inline int writePlanImage(
+  const char* path, const char* engine, unsigned int n,
+  const double* cosines, unsigned int nCosines,
+  const unsigned int* permute, unsigned int nPermute
+) {
+  PlanImageHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, planImageMagic, sizeof(header.magic));
+  strncpy(header.engine, engine, sizeof(header.engine) - 1);
+  header.n = n;
+  header.nCosines = nCosines;
+  header.nPermute = nPermute;
+
+  // A unique name in the same directory (so that `rename` does not cross
+  // file systems), so that concurrent writers of the same image do not
+  // write to the same temporary file.
+  static const char suffix[] = ".XXXXXX";
+  const size_t pathLength = strlen(path);
+  char* tmpPath = new char[pathLength + sizeof(suffix)];
+  memcpy(tmpPath, path, pathLength);
+  memcpy(tmpPath + pathLength, suffix, sizeof(suffix));
+
+  const int fd = mkstemp(tmpPath);
+  if (fd < 0) {
+    delete[] tmpPath;
+    return -1;
+  }
+  // (mkstemp creates the file only readable by the owner.)
+  FILE* file = fchmod(fd, 0644) == 0 ? fdopen(fd, "wb") : 0;
+  if (!file) {
+    close(fd);
+    unlink(tmpPath);
+    delete[] tmpPath;
+    return -1;
+  }
+  const bool ok =
+    fwrite(&header, sizeof(header), 1, file) == 1 &&
+    fwrite(cosines, sizeof(double), nCosines, file) == nCosines &&
+    fwrite(permute, sizeof(unsigned int), nPermute, file) == nPermute;
+  const bool closed = fclose(file) == 0;
+  const int result = ok && closed && rename(tmpPath, path) == 0 ? 0 : -1;
+  if (result != 0) {
+    unlink(tmpPath);
+  }
+  delete[] tmpPath;
+  return result;
+}
+
+// Map the image at `path` and check that it belongs to `engine` and that
+// the file size matches the header.  (The caller checks the table sizes.)
+// Returns 0 on success and -1 on failure.
+inline int mapPlanImage(const char* path, const char* engine, PlanImage* image) {
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return -1;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(PlanImageHeader)) {
+    close(fd);
+    return -1;
+  }
+  const size_t size = st.st_size;
+  void* base = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping stays valid after closing the file.
+  close(fd);
+  if (base == MAP_FAILED) {
+    return -1;
+  }
+
+  const PlanImageHeader* header = (const PlanImageHeader*) base;
+  const unsigned int n = header->n;
+  if (
+    memcmp(header->magic, planImageMagic, sizeof(header->magic)) != 0 ||
+    strncmp(header->engine, engine, sizeof(header->engine)) != 0 ||
+    n == 0 || (n & (n - 1)) != 0 ||
+    size != sizeof(PlanImageHeader)
+      + (size_t) header->nCosines * sizeof(double)
+      + (size_t) header->nPermute * sizeof(unsigned int)
+  ) {
+    munmap(base, size);
+    return -1;
+  }
+
+  const double* cosines = (const double*) (header + 1);
+  image->base = base;
+  image->size = size;
+  image->n = n;
+  image->nCosines = header->nCosines;
+  image->nPermute = header->nPermute;
+  image->cosines = cosines;
+  image->permute = (const unsigned int*) (cosines + header->nCosines);
+  return 0;
+}
+
+inline void unmapPlanImage(const PlanImage* image) {
+  munmap(image->base, image->size);
+}
+
+#endif
+
+class FFT;
+
+extern "C" {
+  // Write the tables of the plan to a file.
+  // Returns 0 on success and -1 on failure.
+  // (Only provided by engines supporting it.)
+  int save_fft_plan(const FFT* fft, const char* path);
+
+  // Create a plan using the tables mapped read-only from a file written by
+  // `save_fft_plan` of the same version.
+  // Returns a null pointer on failure.  The plan is freed with `delete_fft`.
+  // (Only provided by engines supporting it.)
+  FFT* load_fft_plan(const char* path);
+}
+
+#endif
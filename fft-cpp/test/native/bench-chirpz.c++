@@ -0,0 +1,110 @@
+#include <math.h>
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+
+#include "complex.h++"
+#include "c_bindings.h++"
+#include "chirpz.h++"
+#include "timing.h++"
+
+// Compares zooming into a narrow band with the chirp-z plan and with a
+// zero-padded FFT (of the engine this program is linked with) of the
+// same resolution, which computes all bins and keeps only a few.
+//
+// The input is n samples at 48 kHz (two close sinusoids and some noise).
+// For each total resolution N (a power of 2) both methods compute the m
+// bins of width 48 kHz / N from 1 kHz on.
+//
+// Usage: bench_chirpz_<version> [n [m [lgN...]]]
+// (default: n = 65536, m = 2000, N = 2^20, 2^22, 2^24)
+//
+// The "error" column gives the maximum deviation between the two results
+// relative to their RMS.
+
+const double PI = 3.14159265358979323846;
+const double sampleRate = 48000;
+const double bandStart = 1000;
+
+double relativeError(unsigned int n, const Complex* x, const Complex* y) {
+  double maxError = 0, rms = 0;
+  for (unsigned int i = 0; i < n; i++) {
+    maxError = fmax(maxError, abs(x[i] - y[i]));
+    rms += norm(x[i]);
+  }
+  return maxError / sqrt(rms / n);
+}
+
+void report(unsigned int bigN, const char* name, double t, double error) {
+  std::cout
+    << std::setw(10) << bigN << "  " << std::setw(16) << name
+    << std::setw(12) << std::fixed << std::setprecision(1) << t * 1e6;
+  if (error >= 0) {
+    std::cout << std::setw(12) << std::scientific << std::setprecision(2) << error;
+  }
+  std::cout << std::endl;
+}
+
+int main(int argc, char** argv) {
+  static const unsigned int defaultLgNs[] = {20, 22, 24};
+  const unsigned int n = argc > 1 ? atoi(argv[1]) : 65536;
+  const unsigned int m = argc > 2 ? atoi(argv[2]) : 2000;
+  const unsigned int nSizes = argc > 3 ? argc - 3 : 3;
+
+  Complex* x = new Complex[n];
+  for (unsigned int j = 0; j < n; j++) {
+    x[j] =
+      cos(2 * PI * 1005.3 / sampleRate * j) +
+      0.01 * cos(2 * PI * 1007.9 / sampleRate * j) +
+      0.001 * (drand48() - 0.5);
+  }
+  Complex* viaFFT = new Complex[m];
+  Complex* viaChirpZ = new Complex[m];
+
+  std::cout << "         N            method          µs       error" << std::endl;
+  for (unsigned int s = 0; s < nSizes; s++) {
+    const unsigned int bigN = 1u << (argc > 3 ? atoi(argv[s + 3]) : defaultLgNs[s]);
+    if (bigN < n) {
+      std::cerr << "N must be at least n" << std::endl;
+      return 1;
+    }
+    const unsigned int firstBin = (unsigned int) (bandStart / sampleRate * bigN);
+
+    {
+      FFT* fft = prepare_fft(bigN);
+      Complex* in = new Complex[bigN];
+      Complex* out = new Complex[bigN];
+      const double t = timePerCall([&]() {
+        for (unsigned int j = 0; j < n; j++) {
+          in[j] = x[j];
+        }
+        for (unsigned int j = n; j < bigN; j++) {
+          in[j] = 0;
+        }
+        run_fft(fft, in, out, 1);
+        for (unsigned int k = 0; k < m; k++) {
+          viaFFT[k] = out[firstBin + k];
+        }
+      });
+      report(bigN, "zero-padded FFT", t, -1);
+      delete_fft(fft);
+      delete[] in;
+      delete[] out;
+    }
+
+    {
+      const double t0 = clock();
+      ChirpZ* cz = prepare_chirpz(n, m, (double) firstBin / bigN, 1.0 / bigN);
+      const double tPrepare = (clock() - t0) / CLOCKS_PER_SEC;
+      const double t = timePerCall([&]() { run_chirpz(cz, x, viaChirpZ); });
+      report(bigN, "chirp-z", t, relativeError(m, viaFFT, viaChirpZ));
+      report(bigN, "(prepare)", tPrepare, -1);
+      delete_chirpz(cz);
+    }
+  }
+
+  delete[] x;
+  delete[] viaFFT;
+  delete[] viaChirpZ;
+  return 0;
+}
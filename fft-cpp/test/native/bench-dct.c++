@@ -0,0 +1,186 @@
+#include <math.h>
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+
+#include "complex.h++"
+#include "c_bindings.h++"
+#include "dct.h++"
+#include "timing.h++"
+
+// Compares the DCT plans with computing the same transforms by a larger
+// complex FFT (of the engine this program is linked with):
+// - DCT-II from the 4n-point FFT of the input spread to the odd positions
+//   of a symmetric sequence,
+// - DCT-IV from the 2n-point FFT of the twiddled and zero-padded input.
+//
+// Then it checks the inverses: DCT-III after DCT-II, DST-III after DST-II,
+// and DCT-IV and DST-IV applied twice must give n/2 times the input
+// (timing the second transform), and the MDCT of m = n must reconstruct a
+// stream of blocks delayed by one block (timing forward plus inverse).
+//
+// Usage: bench_dct_<version> [size...]
+//
+// The "error" column gives the maximum deviation between the two results
+// (or between the reconstructed and the original input)
+// relative to their RMS.
+// The exit status is 1 if a reconstruction error exceeds
+// `maxRoundTripError`.
+
+const double PI = 3.14159265358979323846;
+const double maxRoundTripError = 1e-12;
+const unsigned int mdctBlocks = 8;
+
+double relativeError(unsigned int n, const double* x, const double* y) {
+  double maxError = 0, rms = 0;
+  for (unsigned int i = 0; i < n; i++) {
+    maxError = fmax(maxError, fabs(x[i] - y[i]));
+    rms += x[i] * x[i];
+  }
+  return maxError / sqrt(rms / n);
+}
+
+void report(unsigned int n, const char* name, double t, double error) {
+  std::cout
+    << std::setw(8) << n << "  " << std::setw(22) << name
+    << std::setw(12) << std::fixed << std::setprecision(3) << t * 1e6;
+  if (error >= 0) {
+    std::cout << std::setw(12) << std::scientific << std::setprecision(2) << error;
+  }
+  std::cout << std::endl;
+}
+
+int main(int argc, char** argv) {
+  static const unsigned int defaultSizes[] = {64, 1024, 65536};
+  const unsigned int nSizes = argc > 1 ? argc - 1 : 3;
+
+  std::cout << "       n                  method          µs       error" << std::endl;
+  bool ok = true;
+  for (unsigned int s = 0; s < nSizes; s++) {
+    const unsigned int n = argc > 1 ? atoi(argv[s + 1]) : defaultSizes[s];
+
+    double* x = new double[n];
+    for (unsigned int i = 0; i < n; i++) {
+      x[i] = drand48() - 0.5;
+    }
+    double* viaFFT = new double[n];
+    double* viaDCT = new double[n];
+
+    {
+      FFT* fft = prepare_fft(4 * n);
+      Complex* in = new Complex[4 * n];
+      Complex* out = new Complex[4 * n];
+      const double t = timePerCall([&]() {
+        for (unsigned int i = 0; i < 4 * n; i++) {
+          in[i] = 0;
+        }
+        for (unsigned int j = 0; j < n; j++) {
+          in[2 * j + 1] = in[4 * n - 1 - 2 * j] = x[j];
+        }
+        run_fft(fft, in, out, 1);
+        for (unsigned int k = 0; k < n; k++) {
+          viaFFT[k] = 0.5 * out[k].real();
+        }
+      });
+      report(n, "DCT-II via 4n FFT", t, -1);
+      delete_fft(fft);
+      delete[] in;
+      delete[] out;
+
+      DCT* dct = prepare_dct(n, DCT_II);
+      const double tDCT = timePerCall([&]() { run_dct(dct, x, viaDCT); });
+      report(n, "DCT-II", tDCT, relativeError(n, viaFFT, viaDCT));
+      delete_dct(dct);
+    }
+
+    {
+      FFT* fft = prepare_fft(2 * n);
+      Complex* in = new Complex[2 * n];
+      Complex* out = new Complex[2 * n];
+      Complex* pre = new Complex[n];
+      Complex* post = new Complex[n];
+      for (unsigned int j = 0; j < n; j++) {
+        pre[j] = expi(-PI * j / (2 * n));
+        post[j] = expi(-PI * (2 * j + 1) / (4 * n));
+      }
+      const double t = timePerCall([&]() {
+        for (unsigned int j = 0; j < n; j++) {
+          in[j] = x[j] * pre[j];
+          in[n + j] = 0;
+        }
+        run_fft(fft, in, out, 1);
+        for (unsigned int k = 0; k < n; k++) {
+          viaFFT[k] = (out[k] * post[k]).real();
+        }
+      });
+      report(n, "DCT-IV via 2n FFT", t, -1);
+      delete_fft(fft);
+      delete[] in;
+      delete[] out;
+      delete[] pre;
+      delete[] post;
+
+      DCT* dct = prepare_dct(n, DCT_IV);
+      const double tDCT = timePerCall([&]() { run_dct(dct, x, viaDCT); });
+      report(n, "DCT-IV", tDCT, relativeError(n, viaFFT, viaDCT));
+      delete_dct(dct);
+    }
+
+    {
+      static const struct {
+        const char* name;
+        int forward, inverse;
+      } pairs[] = {
+        {"DCT-III of DCT-II", DCT_II, DCT_III},
+        {"DST-III of DST-II", DST_II, DST_III},
+        {"DCT-IV of DCT-IV", DCT_IV, DCT_IV},
+        {"DST-IV of DST-IV", DST_IV, DST_IV},
+      };
+      double* scaled = new double[n];
+      for (unsigned int j = 0; j < n; j++) {
+        scaled[j] = 0.5 * n * x[j];
+      }
+      for (const auto& pair : pairs) {
+        DCT* forward = prepare_dct(n, pair.forward);
+        DCT* inverse = prepare_dct(n, pair.inverse);
+        run_dct(forward, x, viaFFT);
+        const double t = timePerCall([&]() { run_dct(inverse, viaFFT, viaDCT); });
+        const double error = relativeError(n, scaled, viaDCT);
+        report(n, pair.name, t, error);
+        ok = ok && error <= maxRoundTripError;
+        delete_dct(forward);
+        delete_dct(inverse);
+      }
+      delete[] scaled;
+    }
+
+    {
+      const unsigned int length = mdctBlocks * n;
+      double* signal = new double[length];
+      double* reconstructed = new double[length];
+      for (unsigned int i = 0; i < length; i++) {
+        signal[i] = drand48() - 0.5;
+      }
+      MDCT* mdct = prepare_mdct(n, 0);
+      for (unsigned int b = 0; b < mdctBlocks; b++) {
+        mdct_forward(mdct, signal + b * n, viaFFT);
+        mdct_inverse(mdct, viaFFT, reconstructed + b * n);
+      }
+      const double error = relativeError(length - n, signal, reconstructed + n);
+      const double t = timePerCall([&]() {
+        mdct_forward(mdct, signal, viaFFT);
+        mdct_inverse(mdct, viaFFT, reconstructed);
+      });
+      report(n, "MDCT reconstruction", t, error);
+      ok = ok && error <= maxRoundTripError;
+      delete_mdct(mdct);
+      delete[] signal;
+      delete[] reconstructed;
+    }
+
+    delete[] x;
+    delete[] viaFFT;
+    delete[] viaDCT;
+  }
+  return ok ? 0 : 1;
+}
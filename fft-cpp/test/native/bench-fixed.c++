@@ -0,0 +1,104 @@
+#include <math.h>
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+
+#include "complex.h++"
+#include "c_bindings.h++"
+#include "fixed47.h++"
+#include "timing.h++"
+
+// Compares the fixed-point engines with the double engine this program has
+// been linked with.
+//
+// Usage: bench_fixed_<version> [size...]
+//
+// The "error" columns give the maximum absolute error and the signal-to-noise
+// ratio of the fixed-point output relative to the (downscaled) output of the
+// double engine for the same (quantized) input.
+
+template <class T>
+void benchFixed(
+  const char* name,
+  FixedFFT<T>* (*prepare)(unsigned int),
+  void (*run)(FixedFFT<T>*, const FixedComplex<T>*, FixedComplex<T>*, int),
+  void (*del)(FixedFFT<T>*),
+  unsigned int n,
+  const Complex* f
+) {
+  const double one = ldexp(1.0, 8 * sizeof(T) - 1);
+
+  FixedComplex<T>* fq = new FixedComplex<T>[n];
+  Complex* fd = new Complex[n];
+  for (unsigned int i = 0; i < n; i++) {
+    fq[i].re = (T) floor(0.5 + f[i].real() * one);
+    fq[i].im = (T) floor(0.5 + f[i].imag() * one);
+    fd[i] = Complex(fq[i].re / one, fq[i].im / one);
+  }
+
+  FFT* reference = prepare_fft(n);
+  Complex* outd = new Complex[n];
+  run_fft(reference, fd, outd, 1);
+  delete_fft(reference);
+
+  FixedFFT<T>* fft = prepare(n);
+  FixedComplex<T>* outq = new FixedComplex<T>[n];
+  run(fft, fq, outq, 1);
+
+  double maxError = 0, signal = 0, noise = 0;
+  for (unsigned int i = 0; i < n; i++) {
+    const Complex expected = outd[i] * (1.0 / n);
+    const Complex error = Complex(outq[i].re / one, outq[i].im / one) - expected;
+    maxError = fmax(maxError, abs(error));
+    signal += norm(expected);
+    noise += norm(error);
+  }
+
+  const double t = timePerCall([&]() { run(fft, fq, outq, 1); });
+  del(fft);
+
+  std::cout
+    << std::setw(8) << n << "  " << std::setw(8) << name
+    << std::setw(12) << std::fixed << std::setprecision(3) << t * 1e6
+    << std::setw(12) << std::scientific << std::setprecision(2) << maxError
+    << std::setw(10) << std::fixed << std::setprecision(1) << 10 * log10(signal / noise)
+    << std::endl;
+
+  delete[] outq;
+  delete[] outd;
+  delete[] fd;
+  delete[] fq;
+}
+
+int main(int argc, char** argv) {
+  static const unsigned int defaultSizes[] = {64, 1024, 16384, 262144};
+  const unsigned int nSizes = argc > 1 ? argc - 1 : 4;
+
+  std::cout << "       n    engine     µs/call   max error  SNR (dB)" << std::endl;
+  for (unsigned int s = 0; s < nSizes; s++) {
+    const unsigned int n = argc > 1 ? atoi(argv[s + 1]) : defaultSizes[s];
+
+    // Components in [-0.5, 0.5) keep magnitudes below 1.
+    Complex* f = new Complex[n];
+    for (unsigned int i = 0; i < n; i++) {
+      f[i] = Complex(drand48() - 0.5, drand48() - 0.5);
+    }
+
+    FFT* fft = prepare_fft(n);
+    Complex* out = new Complex[n];
+    const double t = timePerCall([&]() { run_fft(fft, f, out, 1); });
+    delete_fft(fft);
+    std::cout
+      << std::setw(8) << n << "  " << std::setw(8) << "double"
+      << std::setw(12) << std::fixed << std::setprecision(3) << t * 1e6
+      << std::endl;
+
+    benchFixed("q31", prepare_fft_q31, run_fft_q31, delete_fft_q31, n, f);
+    benchFixed("q15", prepare_fft_q15, run_fft_q15, delete_fft_q15, n, f);
+
+    delete[] out;
+    delete[] f;
+  }
+
+  return 0;
+}
@@ -0,0 +1,151 @@
+#include <math.h>
+#include <stdint.h>
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+
+#include "complex.h++"
+#include "c_bindings.h++"
+#include "ntt.h++"
+#include "timing.h++"
+
+// Multiplies two random big integers of `size` 64-bit limbs
+// - exactly by the 3-prime NTT convolution of the 64-bit limbs, and
+// - by the engine this program is linked with, using 16-bit limbs
+//   (packing both factors into one complex transform).
+//
+// Usage: bench_ntt_<version> [size...]
+//
+// The "rounding" column gives the maximum distance of the floating-point
+// convolution results from the nearest integer.  If it is not clearly
+// below 0.5, the floating-point product may be wrong ("mismatch").
+
+typedef unsigned __int128 uint128_t;
+
+// product = a * b with the NTT convolution (product has 2 size limbs)
+void multiplyNTT(
+  NTTConvolution* conv, unsigned int size,
+  const uint64_t* a, const uint64_t* b, uint64_t* coefficients, uint64_t* product
+) {
+  ntt_convolve(conv, a, size, b, size, coefficients);
+  // Add the 3-word coefficients at their limb positions.
+  uint64_t acc0 = 0, acc1 = 0, acc2 = 0;
+  for (unsigned int k = 0; k < 2 * size; k++) {
+    if (k < 2 * size - 1) {
+      const uint64_t* c = coefficients + 3 * k;
+      const uint128_t s0 = (uint128_t) acc0 + c[0];
+      const uint128_t s1 = (uint128_t) acc1 + c[1] + (uint64_t) (s0 >> 64);
+      acc0 = (uint64_t) s0;
+      acc1 = (uint64_t) s1;
+      acc2 += c[2] + (uint64_t) (s1 >> 64);
+    }
+    product[k] = acc0;
+    acc0 = acc1;
+    acc1 = acc2;
+    acc2 = 0;
+  }
+}
+
+// product = a * b with a complex FFT of m >= 8 size points
+double multiplyFFT(
+  FFT* fft, unsigned int m, unsigned int size,
+  const uint64_t* a, const uint64_t* b, Complex* in, Complex* out, uint64_t* product
+) {
+  const unsigned int nLimbs = 4 * size;
+  for (unsigned int i = 0; i < m; i++) {
+    in[i] = i < nLimbs
+      ? Complex((a[i >> 2] >> (16 * (i & 3))) & 0xffff, (b[i >> 2] >> (16 * (i & 3))) & 0xffff)
+      : 0;
+  }
+  run_fft(fft, in, out, 1);
+  // Separate the spectra of the real and the imaginary parts and multiply.
+  const unsigned int mMask = m - 1;
+  for (unsigned int k = 0; k < m; k++) {
+    const Complex z = out[k];
+    const Complex zc = conj(out[(m - k) & mMask]);
+    const Complex fa = (z + zc) * 0.5;
+    const Complex fb = (z - zc) * Complex(0, -0.5);
+    in[k] = fa * fb;
+  }
+  run_fft(fft, in, out, -1);
+
+  double maxRounding = 0;
+  uint128_t carry = 0;
+  for (unsigned int k = 0; k < 2 * size; k++) {
+    uint64_t limb = 0;
+    for (unsigned int j = 0; j < 4; j++) {
+      const unsigned int i = 4 * k + j;
+      const double x = i < 2 * nLimbs - 1 ? out[i].real() / m : 0;
+      const double rounded = nearbyint(x);
+      maxRounding = fmax(maxRounding, fabs(x - rounded));
+      carry += (uint64_t) rounded;
+      limb |= (uint64_t) (carry & 0xffff) << (16 * j);
+      carry >>= 16;
+    }
+    product[k] = limb;
+  }
+  return maxRounding;
+}
+
+void report(unsigned int size, const char* name, double t, const char* note) {
+  std::cout
+    << std::setw(8) << size << "  " << std::setw(22) << name
+    << std::setw(12) << std::fixed << std::setprecision(1) << t * 1e6
+    << "  " << note << std::endl;
+}
+
+int main(int argc, char** argv) {
+  static const unsigned int defaultSizes[] = {1024, 16384, 131072};
+  const unsigned int nSizes = argc > 1 ? argc - 1 : 3;
+
+  std::cout << "   limbs                  method          µs  rounding" << std::endl;
+  for (unsigned int s = 0; s < nSizes; s++) {
+    const unsigned int size = argc > 1 ? atoi(argv[s + 1]) : defaultSizes[s];
+
+    uint64_t* a = new uint64_t[size];
+    uint64_t* b = new uint64_t[size];
+    for (unsigned int i = 0; i < size; i++) {
+      a[i] = (uint64_t) lrand48() << 62 ^ (uint64_t) lrand48() << 31 ^ lrand48();
+      b[i] = (uint64_t) lrand48() << 62 ^ (uint64_t) lrand48() << 31 ^ lrand48();
+    }
+    uint64_t* productNTT = new uint64_t[2 * size];
+    uint64_t* productFFT = new uint64_t[2 * size];
+
+    NTTConvolution* conv = prepare_ntt_convolution(2 * size - 1, 3);
+    uint64_t* coefficients = new uint64_t[3 * (2 * size - 1)];
+    const double tNTT = timePerCall([&]() {
+      multiplyNTT(conv, size, a, b, coefficients, productNTT);
+    });
+    report(size, "NTT, 64-bit limbs", tNTT, "exact");
+    delete_ntt_convolution(conv);
+    delete[] coefficients;
+
+    unsigned int m = 1;
+    while (m < 8 * size) {
+      m <<= 1;
+    }
+    FFT* fft = prepare_fft(m);
+    Complex* in = new Complex[m];
+    Complex* out = new Complex[m];
+    double maxRounding = 0;
+    const double tFFT = timePerCall([&]() {
+      maxRounding = multiplyFFT(fft, m, size, a, b, in, out, productFFT);
+    });
+    bool match = true;
+    for (unsigned int k = 0; k < 2 * size; k++) {
+      match = match && productNTT[k] == productFFT[k];
+    }
+    char note[64];
+    snprintf(note, sizeof(note), "%.2e%s", maxRounding, match ? "" : " mismatch");
+    report(size, "FFT, 16-bit limbs", tFFT, note);
+    delete_fft(fft);
+    delete[] in;
+    delete[] out;
+
+    delete[] a;
+    delete[] b;
+    delete[] productNTT;
+    delete[] productFFT;
+  }
+  return 0;
+}
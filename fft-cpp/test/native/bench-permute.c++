@@ -0,0 +1,126 @@
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+#include <string.h>
+
+#include "complex.h++"
+#include "cobra.h++"
+#include "engines.h++"
+#include "tables.h++"
+#include "timing.h++"
+
+// Isolates the cost of the bit-reversal permutation in the first pass.
+// For each size it times a plain copy (the memory traffic that no
+// permutation can avoid) and then for each engine
+// - the gather through the engine's own bit-reversal table, as in its
+//   first pass for n < cobraMinN:
+//   - fft47: a table of n/4 entries reversing lg(n/4) bits,
+//   - fft48: a table of n/4 entries reversing lg(n) bits,
+//   - fft99c: a table of n/2 entries for its radix-2 first pass,
+// - the cache-blocked permutation of cobra.h++ in the engine's group size
+//   (4 for fft47 and fft48, 2 for fft99c), as for n >= cobraMinN,
+// - the complete transform.
+// The permutations only copy the values in the order in which the first
+// pass consumes them, without the butterflies.
+//
+// Usage: bench_permute [engine...] (default: fft47, fft48, fft99c)
+// (Only the complete transform is timed for other engines.)
+
+void report(unsigned int n, const char* engine, const char* method, double t) {
+  std::cout
+    << std::setw(10) << n << "  " << std::setw(8) << engine << std::setw(12) << method
+    << std::setw(12) << std::fixed << std::setprecision(1) << t * 1e6
+    << std::setw(10) << std::setprecision(2) << t * 1e9 / n << std::endl;
+}
+
+// The gather of fft47 (shift = 0) or fft48 (shift = 2, since its table
+// reverses lg(n) bits) through a table of n/4 entries
+void gatherQuarter(const Complex* f, Complex* out, unsigned int n, const unsigned int* permute, unsigned int shift) {
+  const unsigned int quarterN = n >> 2;
+  for (unsigned int out_offset = 0; out_offset < n; out_offset += 4) {
+    const unsigned int offset = permute[out_offset >> 2] >> shift;
+    out[out_offset    ] = f[offset];
+    out[out_offset + 1] = f[offset + 2 * quarterN];
+    out[out_offset + 2] = f[offset + quarterN];
+    out[out_offset + 3] = f[offset + 3 * quarterN];
+  }
+}
+
+// The gather of fft99c through a table of n/2 entries
+void gatherHalf(const Complex* f, Complex* out, unsigned int n, const unsigned int* permute) {
+  const unsigned int halfN = n >> 1;
+  for (unsigned int out_offset = 0; out_offset < n; out_offset += 2) {
+    const unsigned int offset = permute[out_offset >> 1];
+    out[out_offset    ] = f[offset];
+    out[out_offset + 1] = f[offset + halfN];
+  }
+}
+
+template <unsigned int groupSize>
+void blocked(const Complex* f, Complex* out, unsigned int n) {
+  bitReversedGroups(f, n, groupSize, [&](unsigned int out_offset, const Complex* x) {
+    for (unsigned int i = 0; i < groupSize; i++) {
+      out[out_offset + i] = x[i];
+    }
+  });
+}
+
+// Time the permutations of the engine `name` (if known).
+void timePermutations(const char* name, unsigned int n, const Complex* f, Complex* out) {
+  const unsigned int quarterN = n >> 2;
+  const unsigned int halfN = n >> 1;
+  if (!strcmp(name, "fft47") || !strcmp(name, "fft48")) {
+    const bool is48 = name[4] == '8';
+    unsigned int* permute = new unsigned int[quarterN];
+    fillBitReversal(permute, quarterN, is48 ? n : quarterN);
+    const unsigned int shift = is48 ? 2 : 0;
+    report(n, name, "gather", timePerCall([&]() {
+      gatherQuarter(f, out, n, permute, shift);
+    }));
+    delete[] permute;
+    report(n, name, "blocked", timePerCall([&]() { blocked<4>(f, out, n); }));
+  } else if (!strcmp(name, "fft99c")) {
+    unsigned int* permute = new unsigned int[halfN];
+    fillBitReversal(permute, halfN, halfN);
+    report(n, name, "gather", timePerCall([&]() { gatherHalf(f, out, n, permute); }));
+    delete[] permute;
+    report(n, name, "blocked", timePerCall([&]() { blocked<2>(f, out, n); }));
+  }
+}
+
+int main(int argc, char** argv) {
+  static const char* const defaultEngines[] = {"fft47", "fft48", "fft99c"};
+  const char* const* engineNames = argc > 1 ? (const char* const*) argv + 1 : defaultEngines;
+  const unsigned int nEngines = argc > 1 ? argc - 1 : 3;
+
+  std::cout << "         n    engine      method          µs  ns/point" << std::endl;
+  for (unsigned int n = 1 << 12; n <= 1 << 24; n <<= 2) {
+    Complex* f = new Complex[n];
+    Complex* out = new Complex[n];
+    for (unsigned int i = 0; i < n; i++) {
+      f[i] = Complex(drand48() - 0.5, drand48() - 0.5);
+    }
+
+    report(n, "", "copy", timePerCall([&]() {
+      memcpy(out, f, n * sizeof(Complex));
+    }));
+
+    for (unsigned int e = 0; e < nEngines; e++) {
+      const FFTEngine* engine = fft_engine_by_name(engineNames[e]);
+      if (!engine) {
+        std::cerr << "unknown engine: " << engineNames[e] << std::endl;
+        return 1;
+      }
+      timePermutations(engine->name, n, f, out);
+      FFTPlan* plan = engine->prepare(n);
+      report(n, engine->name, "transform", timePerCall([&]() {
+        engine->run(plan, f, out, 1);
+      }));
+      engine->destroy(plan);
+    }
+
+    delete[] f;
+    delete[] out;
+  }
+  return 0;
+}
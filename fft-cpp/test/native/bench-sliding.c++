@@ -0,0 +1,102 @@
+#include <math.h>
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+#include <time.h>
+
+#include "complex.h++"
+#include "c_bindings.h++"
+#include "slidingDFT.h++"
+
+// Compares per-sample spectrum updates by the sliding DFT
+// with a full transform per sample by the engine this program is linked with.
+//
+// Usage: bench_sliding_<version> [size...]
+//
+// The "error" column gives the maximum deviation of the tracked bins from a
+// full transform of the final window after `nSamples` samples,
+// relative to the RMS of that transform.
+
+const unsigned int nSamples = 100000;
+const unsigned int nSelectedBins = 8;
+
+// Push all samples and return the time per sample and the final error.
+void benchSliding(
+  const char* name, unsigned int n,
+  const unsigned int* bins, unsigned int nBins, unsigned int resyncInterval,
+  const Complex* samples, const Complex* expected, double rms
+) {
+  SlidingDFT* dft = prepare_sliding_dft(n, bins, nBins, resyncInterval, 1);
+  clock_t start = clock();
+  sliding_dft_push(dft, samples, nSamples);
+  clock_t end = clock();
+  const double t = (end - start) * 1.0 / CLOCKS_PER_SEC / nSamples;
+
+  const Complex* spectrum = sliding_dft_spectrum(dft);
+  double maxError = 0;
+  for (unsigned int j = 0; j < dft->getBinCount(); j++) {
+    maxError = fmax(maxError, abs(spectrum[j] - expected[bins ? bins[j] : j]));
+  }
+  delete_sliding_dft(dft);
+
+  std::cout
+    << std::setw(8) << n << "  " << std::setw(22) << name
+    << std::setw(12) << std::fixed << std::setprecision(3) << t * 1e6
+    << std::setw(12) << std::scientific << std::setprecision(2) << maxError / rms
+    << std::endl;
+}
+
+int main(int argc, char** argv) {
+  static const unsigned int defaultSizes[] = {64, 1024, 16384};
+  const unsigned int nSizes = argc > 1 ? argc - 1 : 3;
+
+  Complex* samples = new Complex[nSamples];
+  for (unsigned int i = 0; i < nSamples; i++) {
+    samples[i] = Complex(drand48() - 0.5, drand48() - 0.5);
+  }
+
+  std::cout << "       n                  method   µs/sample       error" << std::endl;
+  for (unsigned int s = 0; s < nSizes; s++) {
+    const unsigned int n = argc > 1 ? atoi(argv[s + 1]) : defaultSizes[s];
+
+    // The reference spectrum of the last n samples, and the cost of
+    // computing a full transform for each sample.
+    FFT* fft = prepare_fft(n);
+    Complex* expected = new Complex[n];
+    run_fft(fft, samples + nSamples - n, expected, 1);
+    double rms = 0;
+    for (unsigned int i = 0; i < n; i++) {
+      rms += norm(expected[i]);
+    }
+    rms = sqrt(rms / n);
+
+    Complex* out = new Complex[n];
+    const unsigned int nCalls = nSamples / 100;
+    clock_t start = clock();
+    for (unsigned int i = 0; i < nCalls; i++) {
+      run_fft(fft, samples + (i % (nSamples - n)), out, 1);
+    }
+    clock_t end = clock();
+    delete_fft(fft);
+    std::cout
+      << std::setw(8) << n << "  " << std::setw(22) << "run_fft per sample"
+      << std::setw(12) << std::fixed << std::setprecision(3)
+      << (end - start) * 1e6 / CLOCKS_PER_SEC / nCalls
+      << std::endl;
+
+    unsigned int bins[nSelectedBins];
+    for (unsigned int j = 0; j < nSelectedBins; j++) {
+      bins[j] = (j * 7 + 1) & (n - 1);
+    }
+    benchSliding("all bins", n, 0, 0, 0, samples, expected, rms);
+    benchSliding("all bins, resync n", n, 0, 0, n, samples, expected, rms);
+    benchSliding("8 bins", n, bins, nSelectedBins, 0, samples, expected, rms);
+    benchSliding("8 bins, resync 4n", n, bins, nSelectedBins, 4 * n, samples, expected, rms);
+
+    delete[] out;
+    delete[] expected;
+  }
+
+  delete[] samples;
+  return 0;
+}
@@ -0,0 +1,52 @@
+#include <errno.h>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "outOfCore.h++"
+
+// Transform a file of complex doubles with the out-of-core FFT.
+//
+// Usage: fft_file_<version> <input> <output> [<direction> [<memory budget in MiB>]]
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0]
+      << " <input> <output> [<direction> [<memory budget in MiB>]]" << std::endl;
+    return 2;
+  }
+  const char* inputPath = argv[1];
+  const char* outputPath = argv[2];
+  const int direction = argc > 3 ? atoi(argv[3]) : 1;
+  const uint64_t memoryBudget = (argc > 4 ? strtoull(argv[4], 0, 10) : 256) << 20;
+
+  struct stat st;
+  if (stat(inputPath, &st) < 0) {
+    std::cerr << inputPath << ": " << strerror(errno) << std::endl;
+    return 1;
+  }
+  const uint64_t n = st.st_size / sizeof(Complex);
+  if (n == 0 || (n & (n - 1)) != 0 || n * sizeof(Complex) != (uint64_t) st.st_size) {
+    std::cerr << inputPath << ": size is not a power of 2 times "
+      << sizeof(Complex) << " bytes" << std::endl;
+    return 1;
+  }
+
+  OutOfCoreFFT* fft = prepare_fft_ooc(n, memoryBudget);
+  if (!fft) {
+    std::cerr << inputPath << ": " << strerror(errno) << std::endl;
+    return 1;
+  }
+  clock_t start = clock();
+  const int result = run_fft_ooc_files(fft, inputPath, outputPath, direction);
+  clock_t end = clock();
+  delete_fft_ooc(fft);
+  if (result < 0) {
+    std::cerr << strerror(errno) << std::endl;
+    return 1;
+  }
+  std::cout << (end-start) * 1.0 / CLOCKS_PER_SEC << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,57 @@
+#include <math.h>
+#include <iostream>
+#include <iomanip>
+
+// A straight-forward DFT with long double precision
+// as a reference for accuracy measurements.
+//
+// Reads the direction, the size n, and n complex numbers (one per line)
+// from stdin and writes the n output values to stdout.
+
+typedef long double Real;
+
+const Real TAU = 6.283185307179586476925286766559L;
+
+int main() {
+  int direction;
+  unsigned int n;
+  std::cin >> direction >> n;
+
+  Real* re = new Real[n];
+  Real* im = new Real[n];
+  for (unsigned int i = 0; i < n; i++) {
+    std::cin >> re[i] >> im[i];
+  }
+
+  // Exact reduction of the angle index modulo n keeps the table lookups
+  // (and thus the rotations) as accurate as the table itself.
+  Real* cosines = new Real[n];
+  Real* sines = new Real[n];
+  for (unsigned int i = 0; i < n; i++) {
+    cosines[i] = cosl(TAU * i / n);
+    sines[i] = -direction * sinl(TAU * i / n);
+  }
+
+  std::cout << std::setprecision(20);
+  for (unsigned int k = 0; k < n; k++) {
+    Real sumRe = 0, sumIm = 0;
+    unsigned long long m = 0;
+    for (unsigned int j = 0; j < n; j++) {
+      const Real c = cosines[m], s = sines[m];
+      sumRe += re[j] * c - im[j] * s;
+      sumIm += re[j] * s + im[j] * c;
+      m += k;
+      if (m >= n) {
+        m -= n;
+      }
+    }
+    std::cout << (double) sumRe << " " << (double) sumIm << std::endl;
+  }
+
+  delete[] re;
+  delete[] im;
+  delete[] cosines;
+  delete[] sines;
+
+  return 0;
+}
@@ -0,0 +1,62 @@
+#include <math.h>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <stdlib.h>
+
+#include "complex.h++"
+#include "engines.h++"
+
+// Like test.c++, but for all versions in the engine library.
+//
+// Usage: test_all <version> < input
+//
+// Without an argument the available versions are listed.
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    for (unsigned int i = 0; i < fft_engine_count(); i++) {
+      std::cout << fft_engine_at(i)->name << std::endl;
+    }
+    return 0;
+  }
+  const FFTEngine* engine = fft_engine_by_name(argv[1]);
+  if (!engine) {
+    std::cerr << "unknown version: " << argv[1] << std::endl;
+    return 1;
+  }
+
+  unsigned int nCalls;
+  int direction;
+  unsigned int n;
+  std::cin >> nCalls >> direction >> n;
+
+  Complex f[n];
+  for (unsigned int i = 0; i < n; i++) {
+    double re, im;
+    std::cin >> re >> im;
+    f[i] = Complex(re, im);
+  }
+
+  FFTPlan* plan = engine->prepare(n);
+
+  Complex out[n];
+
+
+  clock_t start = clock();
+  for (unsigned int i = 0; i < nCalls; i++) {
+    engine->run(plan, f, out, direction);
+  }
+  clock_t end = clock();
+  double total_time = (end-start) * 1.0 / CLOCKS_PER_SEC;
+
+  std::cout << std::setprecision(20);
+  std::cout << total_time << std::endl;
+  for (unsigned int i = 0; i < n; i++) {
+    std::cout << out[i].real() << " " << out[i].imag() << std::endl;
+  }
+
+  engine->destroy(plan);
+
+  return 0;
+}
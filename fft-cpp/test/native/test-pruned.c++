@@ -0,0 +1,126 @@
+#include <math.h>
+#include <iostream>
+#include <stdlib.h>
+
+#include "complex.h++"
+#include "c_bindings.h++"
+
+// Checks the pruned plans of fft47pruned against a long double DFT.
+//
+// For sizes 1 to 2^maxLgN (default 2^12) and random pruning parameters
+// (including the unpruned and the extreme cases), the inputs from
+// `nonZeroInputs` on are NaN, so that reading them spoils the result,
+// and only the requested cyclic output range is compared.
+//
+// Usage: test_pruned_fft47pruned [maxLgN [rounds per size]]
+//
+// Prints the largest error relative to the RMS of the reference outputs
+// and exits with status 1 if it exceeds `maxRelativeError`.
+
+extern "C" FFT* prepare_fft_pruned(
+  unsigned int n, unsigned int nonZeroInputs, unsigned int outStart, unsigned int outCount
+);
+
+typedef long double Real;
+
+const Real TAU = 6.283185307179586476925286766559L;
+const double maxRelativeError = 1e-12;
+
+// out[k] for k < n, computed from f[0 .. nonZeroInputs)
+void referenceDFT(
+  unsigned int n, unsigned int nonZeroInputs, const Complex* f, int direction,
+  Real* outRe, Real* outIm
+) {
+  Real* cosines = new Real[n];
+  Real* sines = new Real[n];
+  for (unsigned int i = 0; i < n; i++) {
+    cosines[i] = cosl(TAU * i / n);
+    sines[i] = -direction * sinl(TAU * i / n);
+  }
+  for (unsigned int k = 0; k < n; k++) {
+    Real sumRe = 0, sumIm = 0;
+    unsigned int m = 0;
+    for (unsigned int j = 0; j < nonZeroInputs; j++) {
+      const Real c = cosines[m], s = sines[m];
+      sumRe += f[j].real() * c - f[j].imag() * s;
+      sumIm += f[j].real() * s + f[j].imag() * c;
+      m = (m + k) & (n - 1);
+    }
+    outRe[k] = sumRe;
+    outIm[k] = sumIm;
+  }
+  delete[] cosines;
+  delete[] sines;
+}
+
+// The error of one plan relative to the RMS of the requested outputs
+double check(
+  unsigned int n, unsigned int nonZeroInputs, unsigned int outStart, unsigned int outCount,
+  int direction
+) {
+  Complex* f = new Complex[n];
+  Complex* out = new Complex[n];
+  Real* re = new Real[n];
+  Real* im = new Real[n];
+  for (unsigned int j = 0; j < n; j++) {
+    f[j] = j < nonZeroInputs ? Complex(drand48() - 0.5, drand48() - 0.5) : Complex(NAN, NAN);
+  }
+  referenceDFT(n, nonZeroInputs, f, direction, re, im);
+
+  FFT* fft = prepare_fft_pruned(n, nonZeroInputs, outStart, outCount);
+  run_fft(fft, f, out, direction);
+  delete_fft(fft);
+
+  double maxError = 0, rms = 0;
+  for (unsigned int i = 0; i < outCount; i++) {
+    const unsigned int k = (outStart + i) % n;
+    const double error = hypot(out[k].real() - re[k], out[k].imag() - im[k]);
+    // (NaN compares false, so check for it explicitly.)
+    maxError = isnan(error) ? INFINITY : fmax(maxError, error);
+    rms += (double) (re[k] * re[k] + im[k] * im[k]);
+  }
+  rms = sqrt(rms / outCount);
+
+  delete[] f;
+  delete[] out;
+  delete[] re;
+  delete[] im;
+  return rms > 0 ? maxError / rms : maxError;
+}
+
+int main(int argc, char** argv) {
+  const unsigned int maxLgN = argc > 1 ? atoi(argv[1]) : 12;
+  const unsigned int rounds = argc > 2 ? atoi(argv[2]) : 8;
+
+  double worst = 0;
+  unsigned int nChecks = 0;
+  for (unsigned int lgN = 0; lgN <= maxLgN; lgN++) {
+    const unsigned int n = 1 << lgN;
+    for (unsigned int r = 0; r < rounds + 3; r++) {
+      unsigned int nonZeroInputs, outStart, outCount;
+      switch (r) {
+        case 0: nonZeroInputs = n; outStart = 0; outCount = n; break;
+        case 1: nonZeroInputs = 1; outStart = 0; outCount = n; break;
+        case 2: nonZeroInputs = n; outStart = n - 1; outCount = 1; break;
+        default:
+          nonZeroInputs = 1 + lrand48() % n;
+          outStart = lrand48() % n;
+          outCount = 1 + lrand48() % n;
+      }
+      for (int direction = -1; direction <= 1; direction += 2) {
+        const double error = check(n, nonZeroInputs, outStart, outCount, direction);
+        nChecks++;
+        if (!(error <= maxRelativeError)) {
+          std::cerr
+            << "n = " << n << ", nonZeroInputs = " << nonZeroInputs
+            << ", outStart = " << outStart << ", outCount = " << outCount
+            << ", direction = " << direction << ": error " << error << std::endl;
+        }
+        worst = fmax(worst, error);
+      }
+    }
+  }
+
+  std::cout << nChecks << " plans, max relative error " << worst << std::endl;
+  return worst <= maxRelativeError ? 0 : 1;
+}
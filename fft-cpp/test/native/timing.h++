@@ -0,0 +1,28 @@
+#ifndef TIMING_HPP
+#define TIMING_HPP 1
+
+#include <time.h>
+
+// Timing for the native benchmark drivers (CPU time, as in test.c++).
+
+const double minSeconds = 0.2;
+
+// Run `run` repeatedly for at least `minSeconds` and return the time per call.
+template <class Run>
+double timePerCall(Run run) {
+  unsigned int nCalls = 1;
+  for (;;) {
+    clock_t start = clock();
+    for (unsigned int i = 0; i < nCalls; i++) {
+      run();
+    }
+    clock_t end = clock();
+    double total_time = (end-start) * 1.0 / CLOCKS_PER_SEC;
+    if (total_time >= minSeconds) {
+      return total_time / nCalls;
+    }
+    nCalls *= 2;
+  }
+}
+
+#endif
@@ -9,6 +9,7 @@ const indices = (n: number) => new Array(n).fill(undefined).map((x, i) => i);
 
 function fft_native(
   cmd: string,
+  args: string[],
   inputArray: ComplexArray,
   outputArray: ComplexArray,
   nCalls: number,
@@ -25,7 +26,7 @@ function fft_native(
       return `${re} ${im}`;
     }),
   ].map(l => l + "\n").join("");
-  const {stdout, stderr, error} = spawnSync(cmd, [], {input});
+  const {stdout, stderr, error} = spawnSync(cmd, args, {input});
   if (stderr && stderr.length > 0) {
     console.error("native subprocess stderr:");
     console.error("-------------------------");
@@ -51,6 +52,7 @@ class FFTNative implements FFT {
 
   constructor(
     readonly binary: string,
+    readonly version: string,
     public readonly size: number,
   ) {
     this.input = makeComplexArray(size);
@@ -72,10 +74,10 @@ class FFTNative implements FFT {
     return getComplex(this.input, i);
   }
   run(direction: number = 1): void {
-    fft_native(this.binary, this.input, this.output, 1, direction);
+    fft_native(this.binary, [this.version], this.input, this.output, 1, direction);
   }
   runBlock(nCalls: number, direction: number = 1): number {
-    return fft_native(this.binary, this.input, this.output, nCalls, direction);
+    return fft_native(this.binary, [this.version], this.input, this.output, nCalls, direction);
   }
   getOutput(i: number): Complex {
     return getComplex(this.output, i);
@@ -86,14 +88,15 @@ class FFTNative implements FFT {
   }
 }
 
+// All versions are in the engine library linked into `test_all`
+// (see `src/engines.h++`).
+const binary = fileURLToPath(new URL("../test/bin/test_all", import.meta.url));
+
 export const versions: Record<string, () => Promise<FFTFactory>> =
   Object.fromEntries(
     versionNames.map((name) => {
       async function makeFFTFactory(): Promise<FFTFactory> {
-        return (size: number) => new FFTNative(
-          fileURLToPath(new URL("../test/bin/test_" + name, import.meta.url)),
-          size,
-        );
+        return (size: number) => new FFTNative(binary, name, size);
       }
       return [name, makeFFTFactory];
     })
@@ -1,53 +1,113 @@
 import { Complex } from "complex/dst/Complex.js";
 import { FFT, FFTFactory } from "fft-api/dst";
 import decodeBase64 from "base64/dst/decodeBase64.js";
-import { versionNames } from "./info.js";
+import { threadedVersionNames, versionNames } from "./info.js";
 import { makeHeap } from "./makeHeap.js";
+import { ThreadAPI, makeImports } from "./wasm-threads.js";
+import type { ThreadPool } from "./wasm-thread-pool.js";
 
 type API = {
   prepare_fft(n: number): number,
   run_fft(fft: number, input: number, output: number, direction: number): void,
   delete_fft(fft: number): void,
+  /** Fused post-processing (only for some versions, see `src/postprocess.h++`) */
+  set_fft_output?(fft: number, mode: number, forwardScale: number, inverseScale: number): number,
+  /** Plan-owned I/O buffers (only for some versions, see `src/buffers.h++`) */
+  fft_input_buffer?(fft: number): number,
+  fft_output_buffer?(fft: number): number,
 
   malloc(size: number): number,
   free(p: number): void,
+  /** Free all memory allocated by `malloc` (only for the allocator in `src/lib.c`) */
+  heap_reset?(): void,
 };
 
+/** `p` unless it is 0, which the module returns if it runs out of memory. */
+function checkAllocated(p: number, what: string): number {
+  if (p === 0) {
+    throw new Error(`Out of WASM memory in ${what}`);
+  }
+  return p;
+}
+
 class FFTFromWASM implements FFT {
-  private input: number;
-  private output: number;
-  private fft: number;
+  protected input: number;
+  protected output: number;
+  protected fft: number;
+  /** Whether `input` and `output` are owned by the plan (not by us). */
+  private readonly planBuffers: boolean;
   private isDisposed: boolean = false;
+  // A view of the whole memory.  It must be renewed when the memory grows
+  // (which replaces `memory.buffer`).
+  private view: Float64Array;
 
   constructor(
     private readonly memory: WebAssembly.Memory,
-    private readonly api: API,
+    protected readonly api: API,
     public readonly size: number,
   ) {
-    this.input = api.malloc(size * 16);
-    this.output = api.malloc(size * 16);
-    this.fft = api.prepare_fft(size);
+    this.fft = checkAllocated(api.prepare_fft(size), "prepare_fft");
+    this.planBuffers = Boolean(api.fft_input_buffer && api.fft_output_buffer);
+    if (this.planBuffers) {
+      this.input = api.fft_input_buffer!(this.fft);
+      this.output = api.fft_output_buffer!(this.fft);
+      if (!this.input || !this.output) {
+        api.delete_fft(this.fft);
+        checkAllocated(0, "fft_input_buffer");
+      }
+    } else {
+      this.input = api.malloc(size * 16);
+      this.output = api.malloc(size * 16);
+      if (!this.input || !this.output) {
+        this.freeBuffers();
+        api.delete_fft(this.fft);
+        checkAllocated(0, "malloc");
+      }
+    }
+    this.view = new Float64Array(memory.buffer);
   }
 
-  private checkDisposed() {
+  protected checkDisposed() {
     if (this.isDisposed) {
       throw new Error("Trying to use disposed FFTFromWASM instance");
     }
   }
 
+  private memoryView(): Float64Array {
+    if (this.view.buffer !== this.memory.buffer) {
+      this.view = new Float64Array(this.memory.buffer);
+    }
+    return this.view;
+  }
+
+  /**
+   * The input as a `Float64Array` of `2 * size` interleaved real and
+   * imaginary parts, directly on the WASM memory (no copying).
+   * The view becomes invalid when the memory grows,
+   * so get a new one after creating other FFT instances.
+   */
+  inputArray(): Float64Array {
+    this.checkDisposed();
+    return new Float64Array(this.memory.buffer, this.input, 2 * this.size);
+  }
+  /** The output, like `inputArray()`. */
+  outputArray(): Float64Array {
+    this.checkDisposed();
+    return new Float64Array(this.memory.buffer, this.output, 2 * this.size);
+  }
+
   setInput(i: number, value: Complex): void {
     this.checkDisposed();
-    const dv = new DataView(this.memory.buffer);
-    dv.setFloat64(this.input + 16 * i + 0, value.re, true);
-    dv.setFloat64(this.input + 16 * i + 8, value.im, true);
+    const view = this.memoryView();
+    const index = (this.input >> 3) + 2 * i;
+    view[index    ] = value.re;
+    view[index + 1] = value.im;
   }
   getInput(i: number): Complex {
     this.checkDisposed();
-    const dv = new DataView(this.memory.buffer);
-    return {
-      re: dv.getFloat64(this.input + 16 * i + 0, true),
-      im: dv.getFloat64(this.input + 16 * i + 8, true),
-    };  
+    const view = this.memoryView();
+    const index = (this.input >> 3) + 2 * i;
+    return {re: view[index], im: view[index + 1]};
   }
   run(direction: number = 1): void {
     this.checkDisposed();
@@ -63,30 +123,41 @@ class FFTFromWASM implements FFT {
   }
   getOutput(i: number): Complex {
     this.checkDisposed();
-    const dv = new DataView(this.memory.buffer);
-    return {
-      re: dv.getFloat64(this.output + 16 * i + 0, true),
-      im: dv.getFloat64(this.output + 16 * i + 8, true),
-    };
+    const view = this.memoryView();
+    const index = (this.output >> 3) + 2 * i;
+    return {re: view[index], im: view[index + 1]};
   }
 
   // TODO call this from the test-driver code
   dispose() {
     this.checkDisposed();
+    // (Plan-owned buffers are freed by delete_fft.)
     this.api.delete_fft(this.fft);
-    this.api.free(this.input);
-    this.api.free(this.output);
+    if (!this.planBuffers) {
+      this.freeBuffers();
+    }
     this.isDisposed = true;
   }
+
+  private freeBuffers() {
+    if (this.input) {
+      this.api.free(this.input);
+    }
+    if (this.output) {
+      this.api.free(this.output);
+    }
+  }
 }
 
-export const versions: Record<string, () => Promise<FFTFactory>> =
-  Object.fromEntries(
+function makeVersions(
+  importVersion: (name: string) => Promise<{default: string}>,
+): Record<string, () => Promise<FFTFactory>> {
+  return Object.fromEntries(
     versionNames
     .map(name => {
       async function makeFactoryPromise(): Promise<FFTFactory> {
         try {
-          const imported = await import(`../dst-wasm/${name}-wasm.js`);
+          const imported = await importVersion(name);
           const base64_version = imported.default;
           const bytes = decodeBase64(base64_version);
 
@@ -135,15 +206,14 @@ export const versions: Record<string, () => Promise<FFTFactory>> =
             env: {
               ...errorFuncs,
               ...linkFuncs,
+              // Only used by modules without their own allocator.
               ...heap,
-              // TODO use heap management from a (C/C++) library?
-              // but continue to use cos, sin from JS;
-              // (not sure about memset; probably from C lib)
               _Znwm: heap.malloc, // new
               _Znam: heap.malloc, // new[]
               _ZdlPv: heap.free,  // delete
               cos: Math.cos,
               sin: Math.sin,
+              log10: Math.log10,
               __stack_pointer: new WebAssembly.Global({value: 'i32', mutable: true}, stackSize),
               __memory_base: 0,
             },
@@ -158,7 +228,8 @@ export const versions: Record<string, () => Promise<FFTFactory>> =
 
           const instance = await WebAssembly.instantiate(module, imports);
           (instance.exports as any).__wasm_call_ctors?.();
-          const api: API = {...instance.exports as any, ...heap};
+          // Prefer the allocator compiled into the module (see `src/lib.c`).
+          const api: API = {...heap, ...instance.exports as any};
           return (size: number): FFT => new FFTFromWASM(memory, api, size);
         } catch (e) {
           console.error("Problem while setting up WASM instance:", e);
@@ -169,3 +240,222 @@ export const versions: Record<string, () => Promise<FFTFactory>> =
       return [name, makeFactoryPromise];
     })
   );
+}
+
+export const versions: Record<string, () => Promise<FFTFactory>> =
+  makeVersions(name => import(`../dst-wasm/${name}-wasm.js`));
+
+// Feature detection: Can we validate a function returning a v128 value?
+// (Taken from the "wasm-feature-detect" package.)
+export const simdSupported = WebAssembly.validate(new Uint8Array([
+  0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8,
+  0, 65, 0, 253, 15, 253, 98, 11,
+]));
+
+/**
+ * The versions compiled with SIMD128 support (`TECH=WASM_SIMD`).
+ * If the runtime does not support SIMD, these fall back to the scalar code.
+ */
+export const versionsSIMD: Record<string, () => Promise<FFTFactory>> =
+  makeVersions(name =>
+    simdSupported
+    ? import(`../dst-wasm-simd/${name}-wasm.js`)
+    : import(`../dst-wasm/${name}-wasm.js`)
+  );
+
+// ---------------------------------------------------------------------------
+// Threaded flavor (`TECH=WASM_THREADS`, Node only)
+
+type ThreadedAPI = API & ThreadAPI;
+
+class FFTFromThreadedWASM extends FFTFromWASM {
+  constructor(
+    memory: WebAssembly.Memory,
+    api: ThreadedAPI,
+    size: number,
+    private readonly pool: ThreadPool,
+    private readonly parallel: boolean,
+  ) {
+    super(memory, api, size);
+  }
+
+  private runOnce(direction: number): void {
+    if (this.parallel) {
+      this.pool.transform(this.fft, this.input, this.output, direction);
+    } else {
+      this.api.run_fft(this.fft, this.input, this.output, direction);
+    }
+  }
+
+  run(direction: number = 1): void {
+    this.checkDisposed();
+    this.runOnce(direction);
+  }
+  runBlock(nCalls: number, direction: number = 1): number {
+    const start = performance.now();
+    for (let i = 0; i < nCalls; i++) {
+      this.runOnce(direction);
+    }
+    const end = performance.now();
+    return (end - start) * 1e-3;
+  }
+}
+
+/**
+ * `count` transforms of the same size, run in parallel on the workers.
+ * Transform `t` reads its input from `setInput(t, ...)` and writes its output
+ * to `getOutput(t, ...)`.
+ */
+export interface FFTBatch {
+  readonly size: number;
+  readonly count: number;
+  setInput(transform: number, index: number, value: Complex): void;
+  run(direction?: number): void;
+  /** run the batch `nCalls` times and return the total time in seconds */
+  runBlock(nCalls: number, direction?: number): number;
+  getOutput(transform: number, index: number): Complex;
+  dispose(): void;
+}
+
+class FFTBatchFromThreadedWASM implements FFTBatch {
+  private input: number;
+  private output: number;
+  private fft: number;
+  private isDisposed: boolean = false;
+  // A view of the whole memory, renewed when the memory grows
+  // (as in `FFTFromWASM`).
+  private view: Float64Array;
+
+  constructor(
+    private readonly memory: WebAssembly.Memory,
+    private readonly api: ThreadedAPI,
+    private readonly pool: ThreadPool,
+    public readonly size: number,
+    public readonly count: number,
+  ) {
+    this.input = api.malloc(size * count * 16);
+    this.output = api.malloc(size * count * 16);
+    this.fft = api.prepare_fft(size);
+    if (!this.input || !this.output || !this.fft) {
+      this.release();
+      checkAllocated(0, "makeBatch");
+    }
+    this.view = new Float64Array(memory.buffer);
+  }
+
+  private checkDisposed() {
+    if (this.isDisposed) {
+      throw new Error("Trying to use disposed FFTBatchFromThreadedWASM instance");
+    }
+  }
+
+  private memoryView(): Float64Array {
+    if (this.view.buffer !== this.memory.buffer) {
+      this.view = new Float64Array(this.memory.buffer);
+    }
+    return this.view;
+  }
+
+  setInput(transform: number, i: number, value: Complex): void {
+    this.checkDisposed();
+    const view = this.memoryView();
+    const index = (this.input >> 3) + 2 * (transform * this.size + i);
+    view[index    ] = value.re;
+    view[index + 1] = value.im;
+  }
+  run(direction: number = 1): void {
+    this.checkDisposed();
+    this.pool.batch(this.fft, this.input, this.output, direction, this.size, this.count);
+  }
+  runBlock(nCalls: number, direction: number = 1): number {
+    const start = performance.now();
+    for (let i = 0; i < nCalls; i++) {
+      this.pool.batch(this.fft, this.input, this.output, direction, this.size, this.count);
+    }
+    const end = performance.now();
+    return (end - start) * 1e-3;
+  }
+  getOutput(transform: number, i: number): Complex {
+    this.checkDisposed();
+    const view = this.memoryView();
+    const index = (this.output >> 3) + 2 * (transform * this.size + i);
+    return {re: view[index], im: view[index + 1]};
+  }
+
+  dispose() {
+    this.checkDisposed();
+    this.release();
+    this.isDisposed = true;
+  }
+
+  private release() {
+    if (this.fft) {
+      this.api.delete_fft(this.fft);
+    }
+    if (this.input) {
+      this.api.free(this.input);
+    }
+    if (this.output) {
+      this.api.free(this.output);
+    }
+  }
+}
+
+export type ThreadedFFTFactory = FFTFactory & {
+  readonly nWorkers: number,
+  makeBatch(size: number, count: number): FFTBatch,
+  /** Stop the worker threads.  Factories without workers need not be terminated. */
+  terminate(): void,
+};
+
+/**
+ * The versions compiled with atomics and shared memory (`TECH=WASM_THREADS`).
+ *
+ * Each factory starts `nWorkers` worker threads sharing the memory with the
+ * main thread.  Transforms of size `minParallelSize` or larger are split
+ * among the main thread and the workers if the version supports this
+ * (currently fft47mt).  Batches are always distributed.
+ */
+export function makeThreadedVersions(
+  nWorkers: number,
+  {minParallelSize = 1 << 14}: {minParallelSize?: number} = {},
+): Record<string, () => Promise<ThreadedFFTFactory>> {
+  return Object.fromEntries(
+    threadedVersionNames
+    .map(name => {
+      async function makeFactoryPromise(): Promise<ThreadedFFTFactory> {
+        const { ThreadPool } = await import("./wasm-thread-pool.js");
+        const imported = await import(`../dst-wasm-threads/${name}-wasm.js`);
+        const bytes = decodeBase64(imported.default);
+
+        // Must match `--max-memory` in `scripts/compile.mjs`.
+        const memory = new WebAssembly.Memory({initial: 32, maximum: 1 << 14, shared: true});
+        const module = await WebAssembly.compile(bytes);
+        const instance = await WebAssembly.instantiate(module, makeImports(module, memory, {}));
+        const exports = instance.exports as any;
+        exports.__wasm_call_ctors?.();
+        // Threaded modules always have their own allocator (`src/lib.c`).
+        const api: ThreadedAPI = {...exports};
+
+        const stackSize = 1 << 16;
+        const stackTops = new Array(nWorkers).fill(undefined)
+          .map(() => checkAllocated(api.malloc(stackSize), "worker stacks") + stackSize);
+        const pool = await ThreadPool.create(module, memory, api, stackTops);
+        const canSplit = Boolean(api.run_fft_parallel) && nWorkers > 0;
+
+        return Object.assign(
+          (size: number): FFT => new FFTFromThreadedWASM(
+            memory, api, size, pool, canSplit && size >= minParallelSize,
+          ),
+          {
+            nWorkers,
+            makeBatch: (size: number, count: number): FFTBatch =>
+              new FFTBatchFromThreadedWASM(memory, api, pool, size, count),
+            terminate: () => pool.terminate(),
+          },
+        );
+      }
+      return [name, makeFactoryPromise];
+    })
+  );
+}
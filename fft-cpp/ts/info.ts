@@ -3,6 +3,8 @@ export const versionNames = `
   fft02
   fft44
   fft47
+  fft47mt
+  fft47pruned
   fft47pointers
   fft48
   fft60
@@ -11,3 +13,8 @@ export const versionNames = `
   fftKiss
   fftKiss2
 `.trim().split(/\s+/);
+
+// The versions built with `TECH=WASM_THREADS`.
+// (See the corresponding exclusion in `scripts/compile.mjs`.)
+export const threadedVersionNames =
+  versionNames.filter(name => !/^fft0[12]$|^fftKiss2$/.test(name));
@@ -0,0 +1,40 @@
+import { fileURLToPath } from 'url';
+import { spawnSync } from "child_process";
+import { ComplexArray, complexArrayLength, getComplex, makeComplexArray, setComplex } from "complex/dst/ComplexArray.js";
+
+const indices = (n: number) => new Array(n).fill(undefined).map((x, i) => i);
+
+const binary = fileURLToPath(new URL("../test/bin/reference_dft", import.meta.url));
+
+/**
+ * Compute the DFT of `inputArray` with long double precision
+ * in a native subprocess.
+ *
+ * This is a slow O(n^2) implementation to be used as a reference for
+ * accuracy measurements.
+ */
+export function referenceDFT(inputArray: ComplexArray, direction: number = 1): ComplexArray {
+  const n = complexArrayLength(inputArray);
+  const input = [
+    direction,
+    n,
+    ...indices(n).map(i => {
+      const {re, im} = getComplex(inputArray, i);
+      return `${re} ${im}`;
+    }),
+  ].map(l => l + "\n").join("");
+  const {stdout, stderr, error} = spawnSync(binary, [], {input, maxBuffer: 1 << 30});
+  if (stderr && stderr.length > 0) {
+    console.error("reference DFT stderr:");
+    console.error(stderr.toString("utf-8"));
+  }
+  if (error) {
+    throw error;
+  }
+  const outputArray = makeComplexArray(n);
+  stdout.toString("utf-8").trim().split("\n").forEach((line, i) => {
+    const [re, im] = line.split(" ").map(Number);
+    setComplex(outputArray, i, {re, im});
+  });
+  return outputArray;
+}
@@ -0,0 +1,123 @@
+import type { Worker } from "worker_threads";
+import {
+  BARRIER_COUNT, CONTROL_LENGTH, COUNT, DIRECTION, DONE, FAILED, FFT,
+  GENERATION, INPUT, JOB, JOB_BATCH, JOB_EXIT, JOB_TRANSFORM, N_PARTS,
+  OUTPUT, SIZE, JobAborted, ThreadAPI, WorkerData, failJob, runJob,
+} from "./wasm-threads.js";
+
+/**
+ * Worker threads working on the shared memory of a WASM instance
+ * in the main thread.  The main thread takes part in each job as part 0
+ * and the calls return when the job is completed.
+ *
+ * This uses `worker_threads` and blocking `Atomics.wait` in the main
+ * thread and is therefore for Node only.
+ */
+export class ThreadPool {
+  private constructor(
+    private readonly api: ThreadAPI,
+    private readonly control: Int32Array,
+    private readonly workers: Worker[],
+  ) {}
+
+  /**
+   * Start one worker per entry of `stackTops`.
+   * Each worker needs its own stack region in `memory`.
+   */
+  static async create(
+    module: WebAssembly.Module,
+    memory: WebAssembly.Memory,
+    api: ThreadAPI,
+    stackTops: number[],
+  ): Promise<ThreadPool> {
+    const { Worker } = await import(/* webpackIgnore: true */ "worker_threads");
+    const control = new Int32Array(new SharedArrayBuffer(CONTROL_LENGTH * 4));
+    const workers = await Promise.all(stackTops.map((stackTop, i) =>
+      new Promise<Worker>((resolve, reject) => {
+        const workerData: WorkerData = {
+          module, memory, control: control.buffer as SharedArrayBuffer, part: i + 1, stackTop,
+        };
+        const worker = new Worker(new URL("./wasm-worker.js", import.meta.url), {workerData});
+        worker.once("error", reject);
+        worker.once("message", () => {
+          // Idle workers should not keep the process alive.
+          worker.unref();
+          resolve(worker);
+        });
+      })
+    ));
+    return new ThreadPool(api, control, workers);
+  }
+
+  get nParts(): number {
+    return this.workers.length + 1;
+  }
+
+  private runJob(job: number, params: [index: number, value: number][]): void {
+    const {control} = this;
+    if (control[JOB] === JOB_EXIT) {
+      throw new Error("Trying to use terminated thread pool");
+    }
+    control[JOB] = job;
+    control[N_PARTS] = this.nParts;
+    for (const [index, value] of params) {
+      control[index] = value;
+    }
+    Atomics.store(control, DONE, 0);
+    Atomics.store(control, FAILED, 0);
+    // (A failed job may leave threads counted in the barrier.)
+    Atomics.store(control, BARRIER_COUNT, 0);
+    Atomics.add(control, GENERATION, 1);
+    Atomics.notify(control, GENERATION);
+
+    // If our part fails, release the workers before rethrowing.
+    let error: unknown = undefined;
+    try {
+      runJob(this.api, control, 0);
+    } catch (e) {
+      if (!(e instanceof JobAborted)) {
+        error = e;
+      }
+      failJob(control);
+    }
+
+    let done: number;
+    while ((done = Atomics.load(control, DONE)) < this.workers.length) {
+      Atomics.wait(control, DONE, done);
+    }
+    if (error !== undefined) {
+      throw error;
+    }
+    if (Atomics.load(control, FAILED)) {
+      throw new Error("Problem in WASM worker thread");
+    }
+  }
+
+  /** Run a single transform, split into parts by `run_fft_parallel`. */
+  transform(fft: number, input: number, output: number, direction: number): void {
+    this.runJob(JOB_TRANSFORM, [
+      [FFT, fft], [INPUT, input], [OUTPUT, output], [DIRECTION, direction],
+    ]);
+  }
+
+  /**
+   * Run `count` transforms of size `size` on consecutive arrays
+   * starting at `input` and `output`, distributing whole transforms.
+   */
+  batch(
+    fft: number, input: number, output: number, direction: number,
+    size: number, count: number,
+  ): void {
+    this.runJob(JOB_BATCH, [
+      [FFT, fft], [INPUT, input], [OUTPUT, output], [DIRECTION, direction],
+      [SIZE, size], [COUNT, count],
+    ]);
+  }
+
+  terminate(): void {
+    const {control} = this;
+    control[JOB] = JOB_EXIT;
+    Atomics.add(control, GENERATION, 1);
+    Atomics.notify(control, GENERATION);
+  }
+}
@@ -0,0 +1,143 @@
+// Code shared by the main thread and the worker threads
+// of the threaded WASM flavor (`TECH=WASM_THREADS`).
+//
+// All threads instantiate the same module on the same shared memory.
+// Jobs are described in a small `Int32Array` on a `SharedArrayBuffer`
+// (the "control" array).  The main thread writes the job parameters,
+// bumps GENERATION, and then works on part 0 of the job itself.
+// Worker i works on part i.
+
+// Indices into the control array
+export const GENERATION = 0;
+export const JOB = 1;
+export const DONE = 2;
+export const FAILED = 3;
+export const BARRIER_COUNT = 4;
+export const BARRIER_GENERATION = 5;
+export const N_PARTS = 6;
+export const FFT = 7;
+export const INPUT = 8;
+export const OUTPUT = 9;
+export const DIRECTION = 10;
+export const SIZE = 11;
+export const COUNT = 12;
+export const CONTROL_LENGTH = 13;
+
+// Values for control[JOB]
+export const JOB_TRANSFORM = 1;
+export const JOB_BATCH = 2;
+export const JOB_EXIT = 3;
+
+export type ThreadAPI = {
+  run_fft(fft: number, input: number, output: number, direction: number): void,
+  // Only available for versions supporting the parallel execution of a
+  // single transform (see `src/fft47mt.h++`).
+  fft_parallel_steps?(fft: number, nParts: number): number,
+  run_fft_parallel?(
+    fft: number, input: number, output: number, direction: number,
+    step: number, part: number, nParts: number,
+  ): void,
+};
+
+export type WorkerData = {
+  module: WebAssembly.Module,
+  memory: WebAssembly.Memory,
+  control: SharedArrayBuffer,
+  part: number,
+  stackTop: number,
+};
+
+/** Thrown by `barrier` in the threads still running a failed job. */
+export class JobAborted extends Error {
+  constructor() {
+    super("Job aborted after a problem in another thread");
+  }
+}
+
+/**
+ * Mark the current job as failed and release the threads waiting in
+ * `barrier` (which then throw `JobAborted`).
+ */
+export function failJob(control: Int32Array): void {
+  Atomics.store(control, FAILED, 1);
+  Atomics.add(control, BARRIER_GENERATION, 1);
+  Atomics.notify(control, BARRIER_GENERATION);
+}
+
+/**
+ * Wait until `nParties` threads have called this.
+ * Throws `JobAborted` if some thread has called `failJob`.
+ */
+export function barrier(control: Int32Array, nParties: number): void {
+  const generation = Atomics.load(control, BARRIER_GENERATION);
+  // FAILED is set before BARRIER_GENERATION is bumped.  So if we have read
+  // the bumped generation, we see the failure here.
+  if (Atomics.load(control, FAILED)) {
+    throw new JobAborted();
+  }
+  if (Atomics.add(control, BARRIER_COUNT, 1) === nParties - 1) {
+    Atomics.store(control, BARRIER_COUNT, 0);
+    Atomics.add(control, BARRIER_GENERATION, 1);
+    Atomics.notify(control, BARRIER_GENERATION);
+  } else {
+    while (Atomics.load(control, BARRIER_GENERATION) === generation) {
+      Atomics.wait(control, BARRIER_GENERATION, generation);
+    }
+    if (Atomics.load(control, FAILED)) {
+      throw new JobAborted();
+    }
+  }
+}
+
+/** Do this thread's part of the job described in `control`. */
+export function runJob(api: ThreadAPI, control: Int32Array, part: number): void {
+  const nParts = control[N_PARTS];
+  const fft = control[FFT] >>> 0;
+  const input = control[INPUT] >>> 0;
+  const output = control[OUTPUT] >>> 0;
+  const direction = control[DIRECTION];
+  switch (control[JOB]) {
+    case JOB_TRANSFORM: {
+      const steps = api.fft_parallel_steps!(fft, nParts);
+      for (let step = 0; step < steps; step++) {
+        if (step > 0) {
+          barrier(control, nParts);
+        }
+        api.run_fft_parallel!(fft, input, output, direction, step, part, nParts);
+      }
+      break;
+    }
+    case JOB_BATCH: {
+      const bytes = control[SIZE] * 16;
+      const count = control[COUNT];
+      // The parts share the plan, which therefore must stay in the complex
+      // output mode (see `run_fft_with_work` in `src/postprocess.h++`).
+      for (let t = part; t < count; t += nParts) {
+        api.run_fft(fft, input + t * bytes, output + t * bytes, direction);
+      }
+      break;
+    }
+  }
+}
+
+/**
+ * Imports for instantiating `module` on `memory`.
+ *
+ * Functions not given in `funcs` are taken from `Math` (cos, sin)
+ * or throw when called.
+ */
+export function makeImports(
+  module: WebAssembly.Module,
+  memory: WebAssembly.Memory,
+  funcs: Record<string, Function>,
+): WebAssembly.Imports {
+  const env: Record<string, WebAssembly.ImportValue> = {memory};
+  for (const {module: moduleName, name, kind} of WebAssembly.Module.imports(module)) {
+    if (moduleName === "env" && kind === "function") {
+      env[name] = funcs[name] ?? (Math as any)[name] ?? (() => {
+        throw new Error(`Function "${name}" called from WASM is not available`);
+      });
+    }
+  }
+  return {env};
+}
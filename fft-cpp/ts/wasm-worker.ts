@@ -0,0 +1,38 @@
+import {
+  DONE, GENERATION, JOB, JOB_EXIT, JobAborted, ThreadAPI, WorkerData,
+  failJob, makeImports, runJob,
+} from "./wasm-threads.js";
+
+// Entry point of the worker threads started by `wasm-thread-pool.ts`.
+
+// (Not a static import so that bundlers for the browser leave it alone.)
+const { parentPort, workerData } = await import(/* webpackIgnore: true */ "worker_threads");
+const { module, memory, control: controlBuffer, part, stackTop } = workerData as WorkerData;
+const control = new Int32Array(controlBuffer);
+
+// The memory has already been initialized by the main thread and so we
+// must not call `__wasm_call_ctors` again.  Every thread needs its own stack.
+const instance = new WebAssembly.Instance(module, makeImports(module, memory, {}));
+(instance.exports.__stack_pointer as WebAssembly.Global).value = stackTop;
+const api = instance.exports as unknown as ThreadAPI;
+
+parentPort!.postMessage("ready");
+
+let generation = 0;
+for (;;) {
+  Atomics.wait(control, GENERATION, generation);
+  generation = Atomics.load(control, GENERATION);
+  if (Atomics.load(control, JOB) === JOB_EXIT) {
+    break;
+  }
+  try {
+    runJob(api, control, part);
+  } catch (e) {
+    if (!(e instanceof JobAborted)) {
+      console.error(`Problem in WASM worker ${part}:`, e);
+    }
+    failJob(control);
+  }
+  Atomics.add(control, DONE, 1);
+  Atomics.notify(control, DONE);
+}
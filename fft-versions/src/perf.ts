@@ -1,14 +1,19 @@
 import { randomComplex } from "complex/dst/Complex.js";
+import { FFTFactory } from "fft-api/dst";
+import { ThreadedFFTFactory } from "fft-cpp/dst/api-wasm.js";
 import versions from "./versions.js";
 
 
-const { VERSIONS, SIZES, N_BLOCKS, PAUSE, BLOCK_SIZE } = process.env;
+const { VERSIONS, SIZES, N_BLOCKS, PAUSE, BLOCK_SIZE, BATCH } = process.env;
 
 const versionsRegexp = new RegExp(VERSIONS ?? "");
 const sizes = (SIZES ?? "4,8,512,2048").split(",").map(Number);
 const nBlocks = Number(N_BLOCKS ?? "2");
 const pause = Number(PAUSE ?? "0");
 const blockSize = Number(BLOCK_SIZE ?? "2000");
+// For versions supporting batches (CWT): also measure batches of this many
+// transforms.
+const batchCount = Number(BATCH ?? "0");
 
 async function sleep(milliseconds: number) {
   await new Promise(resolve => setTimeout(resolve, milliseconds));
@@ -41,6 +46,26 @@ async function main() {
           } calls/s;`);
         }
         fft.dispose();
+
+        const {makeBatch} = factory as FFTFactory & Partial<ThreadedFFTFactory>;
+        if (batchCount > 0 && makeBatch) {
+          console.log(`---- n = ${n}, batch of ${batchCount} ----`);
+          const batch = makeBatch(n, batchCount);
+          for (let t = 0; t < batchCount; t++) {
+            for (let i = 0; i < n; i++) {
+              batch.setInput(t, i, randomComplex());
+            }
+          }
+          const nCalls = Math.max(Math.round(blockSize / batchCount), 1);
+          for (let b = 0; b < nBlocks; b++) {
+            await sleep(pause * 1000);
+            const time_per_transform_in_s = batch.runBlock(nCalls) / (nCalls * batchCount);
+            console.log(`${
+              (time_per_transform_in_s * 1e6).toFixed(3).padStart(8)
+            } µs per transform;`);
+          }
+          batch.dispose();
+        }
       }
     }
   } catch (e) {
@@ -0,0 +1,238 @@
+import { mkdir, readFile, writeFile } from "fs/promises";
+import { dirname } from "path";
+import os from "os";
+import { abs2, minus } from "complex/dst/Complex.js";
+import { ComplexArray, getComplex, makeComplexArray, setComplex } from "complex/dst/ComplexArray.js";
+import { FFTFactory } from "fft-api/dst";
+import { referenceDFT } from "fft-cpp/dst/reference-native.js";
+import versions from "./versions.js";
+import { median, welchPValue } from "./statistics.js";
+
+// Performance and accuracy regression tracking.
+//
+// With UPDATE=1 the measurements for the selected versions and sizes are
+// written to the baseline file (keeping other entries of the file).
+// Otherwise they are compared to the baseline and the process exits with
+// status 1 if some version has become significantly slower or less accurate.
+//
+// A slowdown is only reported if it is statistically significant
+// (one-sided Welch's t-test over N_BLOCKS measurements each) and larger
+// than MIN_SLOWDOWN.  Errors are measured against a long double DFT
+// and reported relative to the RMS of the reference output.
+
+const {
+  VERSIONS, SIZES, N_BLOCKS, BLOCK_SIZE, PAUSE,
+  BASELINE, UPDATE, ALPHA, MIN_SLOWDOWN, ERROR_FACTOR,
+} = process.env;
+
+const versionsRegexp = new RegExp(VERSIONS ?? "");
+const sizes = (SIZES ?? "16,256,2048").split(",").map(Number);
+const nBlocks = Number(N_BLOCKS ?? "10");
+const blockSize = Number(BLOCK_SIZE ?? "1000");
+const pause = Number(PAUSE ?? "0");
+const baselinePath = BASELINE ?? "baselines/baseline.json";
+const update = UPDATE === "1";
+const alpha = Number(ALPHA ?? "0.01");
+const minSlowdown = Number(MIN_SLOWDOWN ?? "0.05");
+const errorFactor = Number(ERROR_FACTOR ?? "2");
+
+/** Increment this if the meaning of the stored values changes. */
+const formatVersion = 1;
+
+type Measurement = {
+  /** time per call in µs, one value per block */
+  microseconds: number[],
+  maxError: number,
+  rmsError: number,
+};
+
+type Baseline = {
+  formatVersion: number,
+  updated: string,
+  environment: Record<string, string>,
+  /** indexed by version name and size */
+  results: Record<string, Record<string, Measurement>>,
+};
+
+const environment = (): Record<string, string> => ({
+  node: process.version,
+  platform: process.platform,
+  arch: process.arch,
+  cpu: os.cpus()[0]?.model ?? "unknown",
+});
+
+// A seeded PRNG (mulberry32) so that accuracy results are reproducible.
+function makeRandom(seed: number): () => number {
+  return () => {
+    seed = (seed + 0x6D2B79F5) | 0;
+    let t = seed;
+    t = Math.imul(t ^ (t >>> 15), t | 1);
+    t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+    return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+  };
+}
+
+function makeInput(n: number): ComplexArray {
+  const random = makeRandom(n);
+  const input = makeComplexArray(n);
+  for (let i = 0; i < n; i++) {
+    setComplex(input, i, {re: random() - 0.5, im: random() - 0.5});
+  }
+  return input;
+}
+
+async function sleep(milliseconds: number) {
+  await new Promise(resolve => setTimeout(resolve, milliseconds));
+}
+
+const references = new Map<number, {input: ComplexArray, output: ComplexArray}>();
+function getReference(n: number) {
+  let ref = references.get(n);
+  if (!ref) {
+    const input = makeInput(n);
+    ref = {input, output: referenceDFT(input, 1)};
+    references.set(n, ref);
+  }
+  return ref;
+}
+
+async function measure(factory: FFTFactory, n: number): Promise<Measurement> {
+  const {input, output} = getReference(n);
+  const fft = factory(n);
+  try {
+    for (let i = 0; i < n; i++) {
+      fft.setInput(i, getComplex(input, i));
+    }
+    fft.run(1);
+    let sumRef = 0, sumErr = 0, maxErr = 0;
+    for (let i = 0; i < n; i++) {
+      const expected = getComplex(output, i);
+      const err = abs2(minus(fft.getOutput(i), expected));
+      sumRef += abs2(expected);
+      sumErr += err;
+      maxErr = Math.max(maxErr, err);
+    }
+    const rmsRef = Math.sqrt(sumRef / n);
+
+    fft.runBlock(blockSize); // warm-up (JIT compilers)
+    const microseconds: number[] = [];
+    for (let b = 0; b < nBlocks; b++) {
+      await sleep(pause * 1000);
+      microseconds.push(fft.runBlock(blockSize) / blockSize * 1e6);
+    }
+
+    return {
+      microseconds,
+      maxError: Math.sqrt(maxErr) / rmsRef,
+      rmsError: Math.sqrt(sumErr / n) / rmsRef,
+    };
+  } finally {
+    fft.dispose();
+  }
+}
+
+function compare(base: Measurement | undefined, current: Measurement): string[] {
+  if (!base) {
+    return ["new"];
+  }
+  const problems: string[] = [];
+  const ratio = median(current.microseconds) / median(base.microseconds);
+  const p = welchPValue(base.microseconds, current.microseconds);
+  if (ratio > 1 + minSlowdown && p < alpha) {
+    problems.push(`SLOWER by ${((ratio - 1) * 100).toFixed(1)}% (p = ${p.toExponential(1)})`);
+  }
+  // Add one ulp-ish so that exact results in the baseline do not make every
+  // rounding error a regression.
+  const slack = Number.EPSILON;
+  if (current.maxError > errorFactor * base.maxError + slack) {
+    problems.push(`LESS ACCURATE: max error ${current.maxError.toExponential(2)} (was ${base.maxError.toExponential(2)})`);
+  }
+  if (current.rmsError > errorFactor * base.rmsError + slack) {
+    problems.push(`LESS ACCURATE: RMS error ${current.rmsError.toExponential(2)} (was ${base.rmsError.toExponential(2)})`);
+  }
+  return problems;
+}
+
+async function readBaseline(): Promise<Baseline | undefined> {
+  try {
+    const baseline: Baseline = JSON.parse(await readFile(baselinePath, {encoding: "utf-8"}));
+    if (baseline.formatVersion !== formatVersion) {
+      throw new Error(
+        `${baselinePath} has format version ${baseline.formatVersion}, expected ${formatVersion}`
+      );
+    }
+    return baseline;
+  } catch (e: any) {
+    if (e.code === "ENOENT") {
+      return undefined;
+    }
+    throw e;
+  }
+}
+
+async function main() {
+  try {
+    const baseline = await readBaseline();
+    if (!baseline && !update) {
+      throw new Error(`No baseline at ${baselinePath}; record one with "UPDATE=1 npm run regression"`);
+    }
+    if (baseline && !update) {
+      const env = environment();
+      for (const [key, value] of Object.entries(baseline.environment)) {
+        if (env[key] !== value) {
+          console.warn(`Warning: baseline was measured with ${key} = ${value}, now ${env[key]}`);
+        }
+      }
+    }
+
+    const results: Record<string, Record<string, Measurement>> = {};
+    let nProblems = 0;
+    const selectedVersions =
+      Object.entries(versions).filter(([name]) => versionsRegexp.test(name));
+    for (const [versionName, version] of selectedVersions) {
+      console.log(`==== ${versionName} ====`);
+      const factory = await version();
+      results[versionName] = {};
+      for (const n of sizes) {
+        const current = await measure(factory, n);
+        results[versionName][n] = current;
+        const status = update ? [] : compare(baseline?.results[versionName]?.[n], current);
+        nProblems += status.filter(s => s !== "new").length;
+        console.log(`${
+          String(n).padStart(6)
+        }: ${
+          median(current.microseconds).toFixed(3).padStart(10)
+        } µs; max error ${
+          current.maxError.toExponential(2)
+        }; RMS error ${
+          current.rmsError.toExponential(2)
+        }${
+          status.length > 0 ? "; " + status.join("; ") : ""
+        }`);
+      }
+    }
+
+    if (update) {
+      const updated: Baseline = {
+        formatVersion,
+        updated: new Date().toISOString(),
+        environment: environment(),
+        results: {...baseline?.results},
+      };
+      for (const [versionName, bySize] of Object.entries(results)) {
+        updated.results[versionName] = {...updated.results[versionName], ...bySize};
+      }
+      await mkdir(dirname(baselinePath), {recursive: true});
+      await writeFile(baselinePath, JSON.stringify(updated, null, 2) + "\n");
+      console.log(`Baseline written to ${baselinePath}`);
+    } else if (nProblems > 0) {
+      console.error(`${nProblems} regression(s) found`);
+      process.exit(1);
+    }
+  } catch (e) {
+    console.error(e);
+    process.exit(1);
+  }
+}
+
+main();
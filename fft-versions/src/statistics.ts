@@ -0,0 +1,97 @@
+// Just enough statistics to tell systematic from random slowdowns.
+
+export const mean = (xs: number[]): number =>
+  xs.reduce((sum, x) => sum + x, 0) / xs.length;
+
+export const variance = (xs: number[]): number => {
+  const m = mean(xs);
+  return xs.reduce((sum, x) => sum + (x - m) ** 2, 0) / (xs.length - 1);
+};
+
+export const median = (xs: number[]): number => {
+  const sorted = [...xs].sort((a, b) => a - b);
+  const mid = sorted.length >> 1;
+  return sorted.length & 1 ? sorted[mid] : (sorted[mid - 1] + sorted[mid]) / 2;
+};
+
+// Lanczos approximation
+function logGamma(x: number): number {
+  const g = 7;
+  const c = [
+    0.99999999999980993, 676.5203681218851, -1259.1392167224028,
+    771.32342877765313, -176.61502916214059, 12.507343278686905,
+    -0.13857109526572012, 9.9843695780195716e-6, 1.5056327351493116e-7,
+  ];
+  if (x < 0.5) {
+    return Math.log(Math.PI / Math.sin(Math.PI * x)) - logGamma(1 - x);
+  }
+  x -= 1;
+  let a = c[0];
+  const t = x + g + 0.5;
+  for (let i = 1; i < g + 2; i++) {
+    a += c[i] / (x + i);
+  }
+  return 0.5 * Math.log(2 * Math.PI) + (x + 0.5) * Math.log(t) - t + Math.log(a);
+}
+
+// Continued fraction for the incomplete beta function (modified Lentz)
+function betaContinuedFraction(x: number, a: number, b: number): number {
+  const tiny = 1e-300;
+  let c = 1;
+  let d = 1 - (a + b) * x / (a + 1);
+  if (Math.abs(d) < tiny) d = tiny;
+  d = 1 / d;
+  let h = d;
+  for (let m = 1; m <= 200; m++) {
+    const m2 = 2 * m;
+    let aa = m * (b - m) * x / ((a + m2 - 1) * (a + m2));
+    d = 1 + aa * d; if (Math.abs(d) < tiny) d = tiny;
+    c = 1 + aa / c; if (Math.abs(c) < tiny) c = tiny;
+    d = 1 / d;
+    h *= d * c;
+    aa = -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1));
+    d = 1 + aa * d; if (Math.abs(d) < tiny) d = tiny;
+    c = 1 + aa / c; if (Math.abs(c) < tiny) c = tiny;
+    d = 1 / d;
+    const delta = d * c;
+    h *= delta;
+    if (Math.abs(delta - 1) < 1e-14) break;
+  }
+  return h;
+}
+
+/** the regularized incomplete beta function I_x(a, b) */
+function incompleteBeta(x: number, a: number, b: number): number {
+  if (x <= 0) return 0;
+  if (x >= 1) return 1;
+  const front = Math.exp(
+    logGamma(a + b) - logGamma(a) - logGamma(b)
+    + a * Math.log(x) + b * Math.log(1 - x)
+  );
+  return x < (a + 1) / (a + b + 2)
+    ? front * betaContinuedFraction(x, a, b) / a
+    : 1 - front * betaContinuedFraction(1 - x, b, a) / b;
+}
+
+/**
+ * One-sided Welch's t-test.
+ *
+ * Returns the probability of observing means at least as far apart as in
+ * `xs` and `ys` (with `mean(ys) > mean(xs)`) if both samples came from
+ * distributions with the same mean.
+ * A small value means that `ys` is significantly larger than `xs`.
+ */
+export function welchPValue(xs: number[], ys: number[]): number {
+  const vx = variance(xs) / xs.length;
+  const vy = variance(ys) / ys.length;
+  const diff = mean(ys) - mean(xs);
+  if (vx + vy === 0) {
+    return diff > 0 ? 0 : 1;
+  }
+  const t = diff / Math.sqrt(vx + vy);
+  const df = (vx + vy) ** 2 / (
+    vx ** 2 / (xs.length - 1) + vy ** 2 / (ys.length - 1)
+  );
+  const tail = 0.5 * incompleteBeta(df / (df + t * t), df / 2, 0.5);
+  return t > 0 ? tail : 1 - tail;
+}
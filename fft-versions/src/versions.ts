@@ -1,18 +1,30 @@
+import os from "os";
 import { FFTFactory } from "fft-api/dst";
 
 import { versions as versionsTS         } from "fft-ts/dst/api.js"
 import { versions as versionsCPP_native } from "fft-cpp/dst/api-native.js";
 import { versions as versionsCPP_JS     } from "fft-cpp/dst/api-js.js";
 import { versions as versionsCPP_WASM   } from "fft-cpp/dst/api-wasm.js";
+import { versionsSIMD as versionsCPP_WASM_SIMD } from "fft-cpp/dst/api-wasm.js";
+import { makeThreadedVersions } from "fft-cpp/dst/api-wasm.js";
 import { versions as versionsRust_native } from "fft-rust/dst/api-native.js";
 import { versions as versionsRust_WASM  } from "fft-rust/dst/api-wasm.js";
 import { versions as versionsMyLang     } from "fft-mylang/dst/api.js";
 
+const { WORKERS, PARALLEL_MIN_SIZE } = process.env;
+
+const versionsCPP_WASM_THREADS = makeThreadedVersions(
+  Number(WORKERS ?? Math.max(os.cpus().length - 1, 1)),
+  PARALLEL_MIN_SIZE ? {minParallelSize: Number(PARALLEL_MIN_SIZE)} : {},
+);
+
 const versions: Record<string, () => Promise<FFTFactory>> = Object.fromEntries([
   ...Object.entries(versionsTS         ).map(([name, version]) => ["TJ " + name, async() => version]),
   ...Object.entries(versionsCPP_native ).map(([name, version]) => ["CN " + name, version]),
   ...Object.entries(versionsCPP_JS     ).map(([name, version]) => ["CJ " + name, version]),
   ...Object.entries(versionsCPP_WASM   ).map(([name, version]) => ["CW " + name, version]),
+  ...Object.entries(versionsCPP_WASM_SIMD).map(([name, version]) => ["CWS " + name, version]),
+  ...Object.entries(versionsCPP_WASM_THREADS).map(([name, version]) => ["CWT " + name, version]),
   ...Object.entries(versionsRust_native).map(([name, version]) => ["RN " + name, version]),
   ...Object.entries(versionsRust_WASM  ).map(([name, version]) => ["RW " + name, version]),
   ...Object.entries(versionsMyLang     ).map(([name, version]) => ["MW " + name, version]),